@@ -16,6 +16,37 @@
 #include <ctype.h>
 #include <stdbool.h>
 #include <time.h>
+#include <math.h>
+
+#if defined(_MSC_VER)
+#   define WIN32_LEAN_AND_MEAN
+#   define NOMINMAX
+#   include <windows.h>
+#   include <conio.h>
+#else
+#   include <pthread.h>
+#   include <unistd.h>
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <glob.h>
+#   include <sys/select.h>
+#endif
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#   define CYVA_SSE2 1              /* SSE2 always; AVX2 if the CPU says so */
+#   if defined(_MSC_VER)
+#       include <intrin.h>
+#   endif
+#   include <immintrin.h>
+#endif
+
+#if defined(CYVA_HAVE_ZLIB)
+#   include <zlib.h>                /* link -lz    */
+#endif
+#if defined(CYVA_HAVE_ZSTD)
+#   include <zstd.h>                /* link -lzstd */
+#endif
 
 #include "Helper.h"        /* cyva* primitives & safe-string helpers */
 
@@ -26,400 +57,4584 @@
 #define CSPRINT  cyvaStrcspn
 #define TOK      cyvaStrtok
 
-static char *ci_strstr(const char *h, const char *n)      /* case-insens strstr */
+static char *ci_memmem(const char *h, size_t hl, const char *n)  /* bounded, case-insens */
 {
-    if (!h || !n || !*n) return (char *)h;
     size_t nl = LEN(n);
-    for (; *h; ++h)
-        if (tolower((unsigned char)*h) == tolower((unsigned char)*n) &&
-            !NCMP(h, n, nl)) return (char *)h;
+    if (!h || !nl) return (char *)h;
+    for (size_t i = 0; i + nl <= hl; ++i) {
+        size_t k = 0;
+        while (k < nl && tolower((unsigned char)h[i+k]) ==
+                         tolower((unsigned char)n[k])) ++k;
+        if (k == nl) return (char *)h + i;
+    }
     return NULL;
 }
-static char *lastChr(const char *s, int ch)               /* portable strrchr  */
-{ char *r = NULL; while (s && *s) { if (*s == ch) r = (char *)s; ++s; } return r; }
 
 static void  *xmalloc(size_t n) { void *p = malloc(n); if (!p){perror("OOM");exit(1);} return p; }
+static void  *xcalloc(size_t n, size_t sz) { void *p = calloc(n, sz); if (!p){perror("OOM");exit(1);} return p; }
 static char  *xstrdup(const char *s){ char *p = (char*)xmalloc(LEN(s)+1); cyvaStrcpy_cap(p, LEN(s)+1, s); return p; }
 
-/* -- 2.  forward prototypes so the compiler knows the type -- */
-static char *afterTag(const char *msg, const char *tag);
-static char *afterTagFull(const char *msg, const char *tag);
+/* -----------------------------------------------------------
+   ARENA  –  bump allocator that owns everything parsed out of
+   one dataset (names, reasons, timestamps, set storage).
+   Blocks double from 64 KB up to 16 MB, so even a multi-GB
+   load is a handful of blocks and arenaFree() is effectively
+   O(1).  Individual allocations are never freed.
+   ----------------------------------------------------------- */
+#define cArenaMin  (64u << 10)
+#define cArenaMax  (16u << 20)
+
+typedef struct ARENABLK { struct ARENABLK *next; size_t used, cap; } ARENABLK;
+typedef struct { ARENABLK *head; size_t nextCap; } ARENA;
+#define cArenaHdr  ((sizeof(ARENABLK) + 15) & ~(size_t)15)
 
+static void *arenaAlloc(ARENA *a, size_t n)
+{
+    n = (n + 15) & ~(size_t)15;                  /* keep 16-byte alignment */
+    ARENABLK *b = a->head;
+    if (!b || b->used + n > b->cap) {
+        size_t cap = a->nextCap ? a->nextCap : cArenaMin;
+        if (cap < cArenaMax) a->nextCap = cap * 2;
+        if (cap < n) cap = n;
+        b = (ARENABLK*)xmalloc(cArenaHdr + cap);
+        b->used = 0; b->cap = cap; b->next = a->head; a->head = b;
+    }
+    void *p = (char *)b + cArenaHdr + b->used;
+    b->used += n;
+    return p;
+}
+static void *arenaCalloc(ARENA *a, size_t n)
+{
+    char *p = (char *)arenaAlloc(a, n);
+    for (size_t i = 0; i < n; ++i) p[i] = 0;
+    return p;
+}
+static char *arenaStrdup(ARENA *a, const char *s)
+{
+    size_t n = LEN(s) + 1;
+    char  *p = (char *)arenaAlloc(a, n);
+    cyvaMemcpy(p, s, n);
+    return p;
+}
+static void arenaFree(ARENA *a)
+{
+    while (a->head) { ARENABLK *n = a->head->next; free(a->head); a->head = n; }
+    a->nextCap = 0;
+}
+
+/* -- 2.  message tokenizer --------------------------------- */
 /* -----------------------------------------------------------
-   afterTag  –  single-token field (“Status: 0xC000006E”)
+   Marker automaton  –  every literal the analyzer looks for
+   (field keys, section headers, free-text markers) compiled
+   once into a case-insensitive Aho-Corasick DFA.  Bytes are
+   folded into a few character classes, so the table is
+   states × classes shorts and each byte costs one lookup no
+   matter how many markers there are.  To recognise a new
+   field or marker, add it to the enum and kMarker[] only.
    ----------------------------------------------------------- */
-static char *afterTag(const char *msg, const char *tag)
+enum {
+    mkAccountName, mkLogonAccount,
+    mkFailureReason, mkErrorCode, mkStatus,
+    mkCallerComputer, mkSourceWorkstation, mkWorkstationName,
+    mkSourceAddress, mkClientAddress, mkLogonId,
+    mkSecLockedOut, mkSecLogonFailed, mkSecNewLogon,
+    mkLockedOutText, mkLockedOutCode,
+    mkCount
+};
+static const char *const kMarker[mkCount] = {
+    "Account Name", "Logon Account",
+    "Failure Reason", "Error Code", "Status",
+    "Caller Computer Name", "Source Workstation", "Workstation Name",
+    "Source Network Address", "Client Address", "Logon ID",
+    "Account That Was Locked Out", "Account For Which Logon Failed", "New Logon",
+    "account locked out", "0xC0000234",
+};
+
+#define cAcStates  1024
+#define cAcClasses 64
+
+typedef unsigned long long MKSET;               /* bit per marker */
+
+static short         acDelta[cAcStates][cAcClasses];
+static MKSET         acOut[cAcStates];
+static unsigned char acCls[256];
+static unsigned char acLen[mkCount];
+static int           acNStates = 0;
+
+static void acBuild(void)
 {
-    char *p = ci_strstr(msg, tag);
-    if (!p) return NULL;
+    if (acNStates) return;                       /* built once */
+
+    int nCls = 1;                                /* 0 = not in any marker */
+    for (int m = 0; m < mkCount; ++m)
+        for (const char *c = kMarker[m]; *c; ++c) {
+            unsigned char lo = (unsigned char)tolower((unsigned char)*c);
+            if (!acCls[lo]) acCls[lo] = acCls[toupper(lo)] = (unsigned char)nCls++;
+        }
 
-    p += LEN(tag);
-    while (*p == ' ' || *p == ':' || *p == '\t') ++p;
+    for (int s = 0; s < cAcStates; ++s)
+        for (int c = 0; c < cAcClasses; ++c) acDelta[s][c] = -1;
+    int nStates = 1;
 
-    char buf[128]; int i = 0;
-    while (*p && !isspace((unsigned char)*p) && i < 127)
-        buf[i++] = *p++;
-    buf[i] = '\0';
+    for (int m = 0; m < mkCount; ++m) {          /* trie */
+        int s = 0;
+        for (const char *c = kMarker[m]; *c; ++c) {
+            int k = acCls[(unsigned char)*c];
+            if (acDelta[s][k] < 0) acDelta[s][k] = (short)nStates++;
+            s = acDelta[s][k];
+        }
+        acOut[s] |= (MKSET)1 << m;
+        acLen[m]  = (unsigned char)LEN(kMarker[m]);
+    }
 
-    return i ? xstrdup(buf) : NULL;
+    static short fail[cAcStates], queue[cAcStates];
+    int qh = 0, qt = 0;
+    for (int c = 0; c < cAcClasses; ++c) {       /* BFS: complete the DFA */
+        if (acDelta[0][c] < 0) acDelta[0][c] = 0;
+        else { fail[acDelta[0][c]] = 0; queue[qt++] = acDelta[0][c]; }
+    }
+    while (qh < qt) {
+        int s = queue[qh++];
+        for (int c = 0; c < cAcClasses; ++c) {
+            int t = acDelta[s][c];
+            if (t < 0) { acDelta[s][c] = acDelta[fail[s]][c]; continue; }
+            fail[t]   = acDelta[fail[s]][c];
+            acOut[t] |= acOut[fail[t]];
+            queue[qt++] = (short)t;
+        }
+    }
+    acNStates = nStates;
 }
 
 /* -----------------------------------------------------------
-   afterTagFull  –  whole-phrase field (“Failure Reason: …”)
+   acScan  –  one pass over [p, p+n); calls hit(marker, end)
+   for every occurrence, returns the set of markers seen.
    ----------------------------------------------------------- */
-static char *afterTagFull(const char *msg, const char *tag)
+typedef void (*ACHIT)(void *ctx, int marker, const char *end);
+
+static MKSET acScan(const char *p, size_t n, ACHIT hit, void *ctx)
+{
+    MKSET seen = 0; int s = 0;
+    for (size_t i = 0; i < n; ++i) {
+        s = acDelta[s][acCls[(unsigned char)p[i]]];
+        MKSET o = acOut[s];
+        if (!o) continue;
+        seen |= o;
+        if (hit)
+            for (int m = 0; o; ++m, o >>= 1)
+                if (o & 1) hit(ctx, m, p + i + 1);
+    }
+    return seen;
+}
+
+/* marker that spans exactly [p, p+n), -1 if none */
+static int acExact(const char *p, size_t n)
 {
-    char *p = ci_strstr(msg, tag);
-    if (!p) return NULL;
+    int s = 0;
+    for (size_t i = 0; i < n; ++i) s = acDelta[s][acCls[(unsigned char)p[i]]];
+    for (int m = 0; m < mkCount; ++m)
+        if (((acOut[s] >> m) & 1) && acLen[m] == n) return m;
+    return -1;
+}
 
-    p += LEN(tag);
-    while (*p == ' ' || *p == ':' || *p == '\t') ++p;
+/* -----------------------------------------------------------
+   msgTokenize  –  one pass over a Windows event message that
+   splits its “Section: / Key: Value” layout into MSGF fields.
+     • a field with an empty value opens a section, and the
+       indented fields that follow belong to it;
+     • an unindented field with a value closes the section;
+     • a tab or double space followed by “Key:” also ends a
+       value, so flattened one-line messages split the same.
+   Lines without a key (“An account failed to log on.”) are
+   skipped.  Fields are views into the message, nothing is
+   copied.  Each key is resolved to its marker id and every
+   value is run through the automaton once, so extractors look
+   values up by (section id, key id) and free-text markers are
+   a bit test on MSGF.mark.
+   ----------------------------------------------------------- */
+#define cMaxFields 64
 
-    char buf[256]; int i = 0;
-    while (*p && i < 255) {
-        if ((*p == ' ' && p[1] == ' ') || *p == ',' ||
-            *p == '\r' || *p == '\n')
-            break;
-        buf[i++] = *p++;
-    }
-    while (i && (buf[i-1] == ' ' || buf[i-1] == '.')) --i;
-    buf[i] = '\0';
+typedef struct {
+    const char *k, *v;                  /* key / value views        */
+    unsigned    kLen, vLen;             /* as long as the message   */
+    short sec;                          /* index of section, -1 top */
+    short kid;                          /* marker id of key, -1     */
+} MSGFIELD;
 
-    return i ? xstrdup(buf) : NULL;
+typedef struct { MSGFIELD f[cMaxFields]; int n; MKSET mark; } MSGF;
+
+static bool isKeyCh(char c)
+{
+    return isalnum((unsigned char)c) || c == ' ' || c == '-' || c == '_' ||
+           c == '(' || c == ')' || c == '/';
 }
 
-/* -- 3.  Nice time helper ---------------------------------- */
-static char *niceTime(const char *iso)
+/* length of a “Key:” at p (colon excluded), 0 if none.  The
+   colon must end the token, so “C:\Windows” is not a key. */
+static size_t keyLen(const char *p, const char *e)
 {
-    if (!iso) return xstrdup("");
+    const char *c = p;
+    while (c < e && c - p < 64 && isKeyCh(*c)) ++c;
+    if (c - p < 2 || c == e || *c != ':' || !isalpha((unsigned char)*p)) return 0;
+    if (c + 1 < e && !isspace((unsigned char)c[1])) return 0;
+    while (c > p && c[-1] == ' ') --c;
+    return (size_t)(c - p);
+}
 
-    char d[11] = {0}, t[9] = {0};
-    if (sscanf(iso, "%10[^T]T%8[^U]", d, t) != 2)
-        return xstrdup(iso);                     /* not ISO – keep raw */
+static void msgTokenize(const char *m, size_t n, MSGF *mf)
+{
+    const char *p = m, *e = m + n;
+    int  sec = -1;
+    bool bol = true;                             /* at beginning of line */
 
-    struct tm tm = {0};
+    mf->n = 0; mf->mark = 0;
+    while (p < e && mf->n < cMaxFields) {
+        bool indent = false;
+        while (p < e && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')) {
+            if (*p == '\r' || *p == '\n') bol = true;
+            else if (bol) indent = true;
+            ++p;
+        }
+        if (p == e) break;
+        bool atBol = bol; bol = false;
 
-#if defined(_MSC_VER)                            /* no strptime there */
-    sscanf(d, "%d-%d-%d", &tm.tm_year, &tm.tm_mon, &tm.tm_mday);
-    sscanf(t, "%d:%d:%d", &tm.tm_hour, &tm.tm_min, &tm.tm_sec);
-    tm.tm_year -= 1900;  tm.tm_mon -= 1;
-#else
-    strptime(d, "%Y-%m-%d", &tm);
-    strptime(t, "%H:%M:%S", &tm);
-#endif
-    tm.tm_isdst = -1;                            /* let libc decide */
+        size_t kl = keyLen(p, e);
+        if (!kl) {                               /* prose: skip to next field */
+            while (p < e && *p != '\r' && *p != '\n') {
+                if (*p == '\t' || (*p == ' ' && p + 1 < e && p[1] == ' ')) break;
+                ++p;
+            }
+            continue;
+        }
 
-    /* --- convert *UTC* tm → epoch seconds ----------------- */
-    time_t epoch;
-#if defined(_MSC_VER)
-    epoch = _mkgmtime(&tm);                      /* MSVC: gmtime-like */
-#else
-#   if defined(__USE_BSD) || defined(__GNU_LIBRARY__)
-    epoch = timegm(&tm);                         /* GNU / BSD ext     */
-#   else
-    epoch = timegm(&tm);                         /* or your own stub  */
-#   endif
-#endif
+        MSGFIELD *f = &mf->f[mf->n];
+        f->k = p; f->kLen = (unsigned)kl;
+        f->kid = (short)acExact(p, kl);
+        while (*p != ':') ++p;
+        ++p;
+        const char *gap = p;
+        while (p < e && (*p == ' ' || *p == '\t')) ++p;
+        if (p - gap > 1 && keyLen(p, e)) p = gap; /* “Section:  Key: …” */
 
-    /* --- epoch (UTC) → local struct tm -------------------- */
-    struct tm loc;
-#if defined(_MSC_VER)
-    localtime_s(&loc, &epoch);
-#else
-    localtime_r(&epoch, &loc);
-#endif
+        f->v = p;
+        while (p < e && *p != '\r' && *p != '\n') {
+            if (*p == '\t' || (*p == ' ' && p + 1 < e && p[1] == ' ')) {
+                const char *q = p;
+                while (q < e && (*q == ' ' || *q == '\t')) ++q;
+                if (keyLen(q, e)) break;          /* next inline field */
+            }
+            ++p;
+        }
+        const char *ve = p;
+        while (ve > f->v && (ve[-1] == ' ' || ve[-1] == '\t')) --ve;
+        f->vLen = (unsigned)(ve - f->v);
+        mf->mark |= acScan(f->v, f->vLen, NULL, NULL);
 
-    char buf[32];
-    strftime(buf, sizeof buf, "%a %b %d %H:%M:%S", &loc);
-    return xstrdup(buf);
+        if (!f->vLen)             sec = mf->n;   /* section header */
+        else if (atBol && !indent) sec = -1;     /* top-level field */
+        f->sec = f->vLen ? (short)sec : -1;
+        ++mf->n;
+    }
 }
 
-/* -- 4.  raw-event table ----------------------------------- */
-typedef struct { char *msg, *ts; int id; } EVENT;
-static EVENT *ev = NULL; static int evCnt = 0, evCap = 0;
-
-static void pushEv(const char *m, const char *t, int id)
+/* section -1 = first match anywhere */
+static const MSGFIELD *msgField(const MSGF *mf, int section, int key)
 {
-    if (evCnt == evCap) { evCap = evCap ? evCap * 2 : 1024;
-                          ev    = (EVENT*)realloc(ev, evCap * sizeof *ev); }
-    ev[evCnt].msg = xstrdup(m);
-    ev[evCnt].ts  = xstrdup(t);
-    ev[evCnt].id  = id;
-    ++evCnt;
+    for (int i = 0; i < mf->n; ++i) {
+        const MSGFIELD *f = &mf->f[i];
+        if (f->kid != key || !f->vLen) continue;
+        if (section < 0 || (f->sec >= 0 && mf->f[f->sec].kid == section))
+            return f;
+    }
+    return NULL;
 }
 
-/* -- 5.  Per-account stats --------------------------------- */
-typedef struct {
-    char  *name;
-    int    succ, fail, locks;
-    char  *workstation;
-    char **lockTS;  int ltCnt,  ltCap;
-    char **failRS;  int frCnt,  frCap;
-} ACCT;
-
-static ACCT *acct = NULL; static int aCnt = 0, aCap = 0;
+/* single token (“Status: 0xC000006E”) */
+static size_t fieldToken(const MSGFIELD *f, char *out, size_t cap)
+{
+    size_t i = 0;
+    if (f) while (i < f->vLen && i + 1 < cap && !isspace((unsigned char)f->v[i]))
+        { out[i] = f->v[i]; ++i; }
+    out[i] = '\0';
+    return i;
+}
 
-static ACCT *getAcct(const char *n, bool mk)
+/* whole phrase (“Failure Reason: …”), trailing dots dropped */
+static size_t fieldPhrase(const MSGFIELD *f, char *out, size_t cap)
 {
-    for (int i = 0; i < aCnt; ++i)
-        if (!CMP(acct[i].name, n)) return &acct[i];
+    size_t i = 0;
+    if (f) while (i < f->vLen && i + 1 < cap && f->v[i] != ',')
+        { out[i] = f->v[i]; ++i; }
+    while (i && (out[i-1] == ' ' || out[i-1] == '.')) --i;
+    out[i] = '\0';
+    return i;
+}
 
-    if (!mk) return NULL;
-    if (aCnt == aCap) { aCap = aCap ? aCap * 2 : 64;
-                        acct = (ACCT*)realloc(acct, aCap * sizeof *acct); }
+/* -- 3.  Nice time helper ---------------------------------- */
+/* -----------------------------------------------------------
+   Timestamps are kept as 64-bit UTC epoch seconds.  parseTime
+   is a hand-rolled ISO-8601 reader (“2025-10-09T08:53:21.5Z”,
+   ‘T’ or space, optional fraction and ±hh:mm); anything else
+   is cNoTime.  Local time is only produced when a report prints
+   a value: fmtTime() caches the UTC→local offset per UTC hour
+   and does the calendar maths itself, so localtime() runs once
+   per distinct hour rather than once per lock-out.
+   ----------------------------------------------------------- */
+#define cNoTime  (-0x7FFFFFFFFFFFFFFFLL - 1)
 
-    ACCT *a = &acct[aCnt++];
-    a->name = xstrdup(n);
-    a->succ = a->fail = a->locks = 0;
-    a->workstation = NULL;
-    a->lockTS = a->failRS = NULL;    a->ltCnt = a->frCnt = a->ltCap = a->frCap = 0;
-    return a;
-}
-static void pushS(char ***arr, int *cnt, int *cap, const char *s)
+static long long floorDiv(long long a, long long b)
+{ long long q = a / b; return (a % b && (a < 0) != (b < 0)) ? q - 1 : q; }
+
+static long long daysFromCivil(long long y, unsigned m, unsigned d)
 {
-    for (int i = 0; i < *cnt; ++i) if (!CMP((*arr)[i], s)) return;
-    if (*cnt == *cap) { *cap = *cap ? *cap * 2 : 8;
-                        *arr = (char**)realloc(*arr, *cap * sizeof **arr); }
-    (*arr)[(*cnt)++] = xstrdup(s);
+    y -= m <= 2;
+    long long era = floorDiv(y, 400);
+    unsigned  yoe = (unsigned)(y - era * 400);
+    unsigned  doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+    unsigned  doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + (long long)doe - 719468;
 }
 
-/* -- 6.  message-parsing helpers --------------------------- */
-static char *userInSection(const char *msg,
-                           const char *sectionHdr,
-                           const char *tag)      /* usually "Account Name" */
+static void civilFromDays(long long z, long long *y, unsigned *m, unsigned *d)
 {
-    char *sec = ci_strstr(msg, sectionHdr);
-    return sec ? afterTag(sec, tag) : NULL;
+    z += 719468;
+    long long era = floorDiv(z, 146097);
+    unsigned  doe = (unsigned)(z - era * 146097);
+    unsigned  yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    unsigned  doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    unsigned  mp  = (5 * doy + 2) / 153;
+    *d = doy - (153 * mp + 2) / 5 + 1;
+    *m = mp < 10 ? mp + 3 : mp - 9;
+    *y = (long long)yoe + era * 400 + (*m <= 2);
 }
 
-static char *userFromMsg(int id, const char *m)
+static int digits(const char *s, int n)          /* -1 if not all digits */
 {
-    switch (id) {
-    case 4740:  /* lock-out */
-        return userInSection(m,
-               "Account That Was Locked Out:", "Account Name");
-
-    case 4625: { /* failed logon */
-        char *u = userInSection(
-               m, "Account For Which Logon Failed:", "Account Name");
-        if (u && CMP(u, "-")) return u;          /* ignore “-” */
-        free(u); return NULL;
+    int v = 0;
+    for (int i = 0; i < n; ++i) {
+        if (s[i] < '0' || s[i] > '9') return -1;
+        v = v * 10 + (s[i] - '0');
     }
+    return v;
+}
 
-    case 4624:  /* success */
-        return userInSection(m, "New Logon:", "Account Name");
+static long long parseTime(const char *s, size_t n)
+{
+    while (n && (*s == ' ' || *s == '"')) { ++s; --n; }
+    if (n < 19 || s[4] != '-' || s[7] != '-' || (s[10] != 'T' && s[10] != ' ') ||
+        s[13] != ':' || s[16] != ':') return cNoTime;
 
-    case 4776: case 4771:                       /* NTLM / Kerberos */
-        return afterTag(m, "Logon Account");
+    int Y = digits(s, 4), M = digits(s + 5, 2), D = digits(s + 8, 2);
+    int h = digits(s + 11, 2), mi = digits(s + 14, 2), se = digits(s + 17, 2);
+    if (Y < 0 || M < 1 || M > 12 || D < 1 || D > 31 ||
+        h < 0 || h > 23 || mi < 0 || mi > 59 || se < 0 || se > 60) return cNoTime;
 
-    default:
-        return NULL;
+    long long t = daysFromCivil(Y, (unsigned)M, (unsigned)D) * 86400 +
+                  h * 3600 + mi * 60 + se;
+
+    size_t i = 19;
+    if (i < n && (s[i] == '.' || s[i] == ','))
+        for (++i; i < n && s[i] >= '0' && s[i] <= '9'; ++i) ;
+    if (i < n && (s[i] == '+' || s[i] == '-') && n - i >= 5) {
+        bool colon = s[i + 3] == ':';            /* ±hh:mm needs 6 bytes */
+        int  oh = digits(s + i + 1, 2);
+        int  om = colon && n - i < 6 ? -1 : digits(s + i + (colon ? 4 : 3), 2);
+        if (oh >= 0 && om >= 0)
+            t -= (s[i] == '+' ? 1 : -1) * (oh * 3600LL + om * 60);
     }
+    return t;
 }
 
-static char *failReason(const char *msg)
+typedef struct { long long hour; int off; bool ok; } TZSLOT;
+static TZSLOT tzCache[256];
+
+static int offsetAt(long long t)                 /* seconds east of UTC */
 {
-    char *r = afterTagFull(msg, "Failure Reason");
-    if (r && *r) return r;
+    time_t    tt = (time_t)t;
+    struct tm loc;
+#if defined(_MSC_VER)
+    localtime_s(&loc, &tt);
+#else
+    localtime_r(&tt, &loc);
+#endif
+    long long asUtc = daysFromCivil(loc.tm_year + 1900LL, (unsigned)loc.tm_mon + 1,
+                                    (unsigned)loc.tm_mday) * 86400 +
+                      loc.tm_hour * 3600 + loc.tm_min * 60 + loc.tm_sec;
+    return (int)(asUtc - t);
+}
 
-    r = afterTagFull(msg, "Error Code");
-    if (r && *r) return r;
+/* hours containing a DST switch (e.g. at :30 UTC) are not cached */
+static int localOffset(long long t)
+{
+    long long hr = floorDiv(t, 3600);
+    TZSLOT *c = &tzCache[hr & 255];
+    if (c->ok && c->hour == hr) return c->off;
 
-    return afterTagFull(msg, "Status");
+    int off = offsetAt(hr * 3600);
+    if (offsetAt(hr * 3600 + 3599) != off) return offsetAt(t);
+    c->hour = hr; c->off = off; c->ok = true;
+    return off;
 }
 
-static char *workstationFromMsg(const char *m)
+/* epoch → “Thu Oct 09 10:53:21” in local time */
+static const char *fmtTime(long long t, char *out, size_t cap)
 {
-    char *w = afterTag(m, "Caller Computer Name"); if (w) return w;
-    w = afterTag(m, "Source Workstation");          if (w) return w;
-    return afterTag(m, "Workstation Name");
+    static const char *const kDay[] = { "Sun","Mon","Tue","Wed","Thu","Fri","Sat" };
+    static const char *const kMon[] = { "Jan","Feb","Mar","Apr","May","Jun",
+                                        "Jul","Aug","Sep","Oct","Nov","Dec" };
+    if (t == cNoTime) { cyvaStrcpy_cap(out, cap, "(unknown time)"); return out; }
+
+    long long loc  = t + localOffset(t);
+    long long days = floorDiv(loc, 86400), sec = loc - days * 86400;
+    long long y; unsigned m, d;
+    civilFromDays(days, &y, &m, &d);
+
+    snprintf(out, cap, "%s %s %02u %02d:%02d:%02d",
+             kDay[(int)(((days + 4) % 7 + 7) % 7)], kMon[m - 1], d,
+             (int)(sec / 3600), (int)(sec / 60 % 60), (int)(sec % 60));
+    return out;
 }
-static bool isLock(int id, const char *m)
+
+/* “2026-10-01[ 02:00[:00]]” (‘T’ allowed) in local time → epoch */
+static bool parseLocal(const char *s, long long *out)
 {
-    if (id == 4740) return true;
-    if (id == 4625 || id == 4776 || id == 4771)
-        return ci_strstr(m, "account locked out") || ci_strstr(m, "0xC0000234");
-    return false;
+    struct tm tm = {0};
+    int n = sscanf(s, "%d-%d-%d%*c%d:%d:%d", &tm.tm_year, &tm.tm_mon,
+                   &tm.tm_mday, &tm.tm_hour, &tm.tm_min, &tm.tm_sec);
+    if (n != 3 && n < 5) return false;
+    tm.tm_year -= 1900; tm.tm_mon -= 1; tm.tm_isdst = -1;
+    *out = (long long)mktime(&tm);
+    return true;
 }
-static bool isNtFail(int id, const char *m)
+
+/* -- 4.  raw-event table ----------------------------------- */
+/* -----------------------------------------------------------
+   EVCOLS  –  the raw events, one array per field, all n long.
+   A pass over one field (time, kind, id) then streams a single
+   packed array instead of striding over whole rows.
+     tmpl  message template in the LOGTAB's ‘msg’ store, with
+     par   the offset of its parameters there, and msgLen the
+           length of the rebuilt text
+     id    Windows event id (16-bit by definition; others 0)
+     acct  owning account's index in its LOGTAB (-1 = none)
+     kind  the evSucc/evFail/evLock bits counted for it
+     ws/ip for failures, the originating workstation and source
+           address in the LOGTAB's ‘src’ set (-1 = unknown)
+     host  the logging computer in its ‘host’ set (-1 = none)
+     lid   Logon ID of a 4624 logon or 4634/4647 logoff (0 = none)
+   ----------------------------------------------------------- */
+enum { evSucc = 1, evFail = 2, evLock = 4 };
+
+typedef struct {
+    int            *tmpl; long long *par; unsigned *msgLen;
+    unsigned short *id;
+    long long      *t;
+    int            *acct;
+    unsigned char  *kind;
+    int            *ws, *ip, *host;
+    unsigned long long *lid;
+    int             n, cap;
+} EVCOLS;
+
+static void evReserve(EVCOLS *c, int need)
 {
-    return (id == 4776 || id == 4771) &&
-           !(ci_strstr(m, "Error Code: 0") || ci_strstr(m, "Status: 0"));
+    if (need <= c->cap) return;
+    int cap = c->cap ? c->cap : 1024;
+    while (cap < need) cap *= 2;
+    c->tmpl   = (int *)           realloc(c->tmpl,   cap * sizeof *c->tmpl);
+    c->par    = (long long *)     realloc(c->par,    cap * sizeof *c->par);
+    c->msgLen = (unsigned *)      realloc(c->msgLen, cap * sizeof *c->msgLen);
+    c->id     = (unsigned short *)realloc(c->id,     cap * sizeof *c->id);
+    c->t      = (long long *)     realloc(c->t,      cap * sizeof *c->t);
+    c->acct   = (int *)           realloc(c->acct,   cap * sizeof *c->acct);
+    c->kind   = (unsigned char *) realloc(c->kind,   cap * sizeof *c->kind);
+    c->ws     = (int *)           realloc(c->ws,     cap * sizeof *c->ws);
+    c->ip     = (int *)           realloc(c->ip,     cap * sizeof *c->ip);
+    c->host   = (int *)           realloc(c->host,   cap * sizeof *c->host);
+    c->lid    = (unsigned long long *)realloc(c->lid, cap * sizeof *c->lid);
+    if (!c->tmpl || !c->par || !c->msgLen || !c->id || !c->t || !c->acct || !c->kind ||
+        !c->ws || !c->ip || !c->host || !c->lid) { perror("OOM"); exit(1); }
+    c->cap = cap;
 }
 
-/* -- 7.  getline-compat for MSVC --------------------------- */
-#if defined(_MSC_VER)
-static ssize_t getline_ms(char **buf, size_t *cap, FILE *fp)
+static void evFree(EVCOLS *c)
 {
-    if (!*buf || !*cap) { *cap = 256; *buf = (char*)malloc(*cap); }
-    size_t n = 0; int ch;
-    while ((ch = fgetc(fp)) != EOF) {
-        if (n + 2 >= *cap) { *cap <<= 1; *buf = (char*)realloc(*buf, *cap); }
-        (*buf)[n++] = (char)ch;
-        if (ch == '\n') break;
-    }
-    if (n == 0 && ch == EOF) return -1;
-    (*buf)[n] = '\0'; return (ssize_t)n;
+    free(c->tmpl); free(c->par); free(c->msgLen); free(c->id); free(c->t);
+    free(c->acct); free(c->kind); free(c->ws); free(c->ip); free(c->host);
+    free(c->lid);
+    *c = (EVCOLS){0};
 }
-#   define GETLINE getline_ms
-#else
-#   define GETLINE getline
-#endif
 
-/* -- 8.  CSV loader (robust) ------------------------------- */
-static bool loadCSV(const char *path)
-{
-    FILE *fp = fopen(path, "r");
-    if (!fp) { perror(path); return false; }
+/* -----------------------------------------------------------
+   Message templates  –  Drain-style compression of the message
+   column.  A message is cut into alternating whitespace runs
+   and words, which concatenate back to the exact text.
+   Messages of one event id and token count form a group and
+   are matched against its live templates: a template fits when
+   at least cTmplSim of the words agree with its literals or
+   fall on wildcards.  Full agreement stores only the wildcard
+   tokens (the parameters); partial agreement derives a more
+   general template with the disagreeing positions made
+   wildcards, which retires the old one for matching (events
+   already encoded keep pointing at it).  A group's first
+   template is all literal, so values that never change (a
+   constant SID, status or logon type) cost nothing per event.
+   Parameters go to one byte heap, each a varint length plus
+   its bytes; msgText() rebuilds the text on demand.  The
+   template last used for an event id is tried first by walking
+   the message against it directly, which settles most rows
+   without tokenizing them.
+   ----------------------------------------------------------- */
+#define cTmplMaxTok 1024                /* the rest folds into the last */
+#define cTmplSim    0.5
 
-    char chunk[4096];
+typedef struct {
+    const char **tok;  unsigned *len;   /* tok[k] NULL: wildcard        */
+    int          id, nTok;
+    int          next;                  /* older template of the group  */
+    bool         old;                   /* retired by a generalisation  */
+} TMPL;
 
-    /* drop header ------------------------------------------- */
-    if (!fgets(chunk, sizeof chunk, fp)) { fclose(fp); return false; }
+typedef struct {
+    TMPL      *tp;   int n, cap;
+    int       *grp;  int grpCnt, grpCap; /* (id, nTok) → newest + 1     */
+    char      *par;  long long parLen, parCap;
+    int        last[64];                /* by id & 63: last template + 1 */
+} MSGSTORE;
 
-    size_t cap = 16384;
-    char  *row = (char *)xmalloc(cap);
+typedef struct { const char *p; unsigned n; } TOKV;
 
-    while (1) {
-        size_t len = 0; bool inQ = false;
+static bool isWs(char c) { return c == ' ' || (c >= '\t' && c <= '\r'); }
 
-        /* reassemble logical row --------------------------- */
-        while (fgets(chunk, sizeof chunk, fp)) {
-            size_t cLen = LEN(chunk);
-            if (len + cLen + 1 > cap) { cap <<= 1; row = (char*)realloc(row, cap); }
-            cyvaMemcpy(row + len, chunk, cLen + 1);
-            len += cLen;
+static int msgTokens(const char *m, size_t n, TOKV *tv)
+{
+    const char *p = m, *e = m + n; int k = 0;
+    while (p < e) {
+        if (k == cTmplMaxTok) { tv[k - 1].n = (unsigned)(e - tv[k - 1].p); break; }
+        const char *b = p;
+        bool sp = isWs(*p);
+        while (p < e && isWs(*p) == sp) ++p;
+        tv[k].p = b; tv[k].n = (unsigned)(p - b); ++k;
+    }
+    return k;
+}
 
-            for (size_t i = 0; i < cLen; ++i) if (chunk[i] == '"') inQ = !inQ;
-            if (!inQ) break;
-        }
-        if (len == 0) break;                  /* EOF */
+static bool tokEq(const char *a, unsigned an, const char *b, unsigned bn)
+{
+    if (an != bn) return false;
+    for (unsigned i = 0; i < an; ++i) if (a[i] != b[i]) return false;
+    return true;
+}
 
-        while (len && (row[len-1] == '\n' || row[len-1] == '\r'))
-            row[--len] = '\0';
-        if (!*row) continue;
+/* the group's slot in grp[] (created empty if new) */
+static int *tmplGroup(MSGSTORE *ms, int id, int nTok)
+{
+    if (2 * (ms->grpCnt + 1) > ms->grpCap) {
+        int  oldCap = ms->grpCap, *old = ms->grp;
+        ms->grpCap = oldCap ? oldCap * 2 : 64;
+        ms->grp    = (int*)xcalloc(ms->grpCap, sizeof *ms->grp);
+        for (int s = 0; s < oldCap; ++s) if (old[s]) {
+            const TMPL *t = &ms->tp[old[s] - 1];
+            unsigned k = ((unsigned)t->id * 2654435761u ^ (unsigned)t->nTok) & (ms->grpCap - 1);
+            while (ms->grp[k]) k = (k + 1) & (ms->grpCap - 1);
+            ms->grp[k] = old[s];
+        }
+        free(old);
+    }
+    unsigned mask = (unsigned)ms->grpCap - 1;
+    unsigned k = ((unsigned)id * 2654435761u ^ (unsigned)nTok) & mask;
+    for (; ms->grp[k]; k = (k + 1) & mask) {
+        const TMPL *t = &ms->tp[ms->grp[k] - 1];
+        if (t->id == id && t->nTok == nTok) return &ms->grp[k];
+    }
+    return &ms->grp[k];
+}
 
-        char *cell[3] = { NULL, NULL, NULL };
-        int col = 0; inQ = false;
-        char *cptr = row, *beg = row;
+/* appends a template (tokens already in ‘ar’) as its group's newest */
+static int tmplPush(MSGSTORE *ms, int id, int nTok, const char **tok, unsigned *len)
+{
+    if (ms->n == ms->cap) {
+        ms->cap = ms->cap ? ms->cap * 2 : 64;
+        ms->tp  = (TMPL*)realloc(ms->tp, ms->cap * sizeof *ms->tp);
+        if (!ms->tp) { perror("OOM"); exit(1); }
+    }
+    int *slot = tmplGroup(ms, id, nTok), i = ms->n++;
+    if (!*slot) ms->grpCnt++;
+    ms->tp[i] = (TMPL){ tok, len, id, nTok, *slot - 1, false };
+    *slot = i + 1;
+    return i;
+}
 
-        while (1) {
-            if (*cptr == '"') { inQ = !inQ; ++cptr; continue; }
-            bool delim = (!inQ && (*cptr == ',' || *cptr == '\t'));
-            if (delim || *cptr == '\0') {
-                if (col < 3) cell[col++] = beg;
-                if (*cptr == '\0') break;
-                *cptr = '\0'; beg = ++cptr; continue;
+/* a new template for tv[]: literal where ‘from’ (if any) agrees,
+   all literal without one */
+static int tmplNew(MSGSTORE *ms, ARENA *ar, int id, const TOKV *tv, int nTok, int from)
+{
+    const char **tok = (const char **)arenaAlloc(ar, nTok * sizeof *tok);
+    unsigned    *len = (unsigned *)   arenaAlloc(ar, nTok * sizeof *len);
+    for (int k = 0; k < nTok; ++k) {
+        tok[k] = NULL; len[k] = 0;
+        if (from >= 0) {
+            const TMPL *f = &ms->tp[from];
+            if (f->tok[k] && tokEq(f->tok[k], f->len[k], tv[k].p, tv[k].n)) {
+                tok[k] = f->tok[k]; len[k] = f->len[k];
             }
-            ++cptr;
+            continue;
+        }
+        bool nul = false;                        /* kept as a parameter */
+        for (unsigned i = 0; i < tv[k].n && !nul; ++i) nul = !tv[k].p[i];
+        if (nul) continue;
+        char *s = (char *)arenaAlloc(ar, tv[k].n + 1);
+        cyvaMemcpy(s, tv[k].p, tv[k].n); s[tv[k].n] = '\0';
+        tok[k] = s; len[k] = tv[k].n;
+    }
+    if (from >= 0) ms->tp[from].old = true;
+    return tmplPush(ms, id, nTok, tok, len);
+}
+
+static void parPut(MSGSTORE *ms, const char *p, unsigned n)
+{
+    if (ms->parLen + n + 5 > ms->parCap) {
+        while (ms->parLen + n + 5 > ms->parCap) ms->parCap = ms->parCap ? ms->parCap * 2 : 1 << 16;
+        ms->par = (char *)realloc(ms->par, (size_t)ms->parCap);
+        if (!ms->par) { perror("OOM"); exit(1); }
+    }
+    unsigned v = n;
+    do { ms->par[ms->parLen++] = (char)((v & 0x7F) | (v > 0x7F ? 0x80 : 0)); v >>= 7; } while (v);
+    cyvaMemcpy(ms->par + ms->parLen, p, n);
+    ms->parLen += n;
+}
+
+/* whether template t reproduces [m, m+n) token for token; the
+   wildcard tokens go to w[] */
+static bool tmplFits(const TMPL *t, const char *m, size_t n, TOKV *w, int *nw)
+{
+    const char *p = m, *e = m + n;
+    *nw = 0;
+    for (int k = 0; k < t->nTok; ++k) {
+        if (p == e) return false;
+        const char *b = p;
+        if (t->tok[k]) {
+            if ((size_t)(e - p) < t->len[k] || !tokEq(p, t->len[k], t->tok[k], t->len[k])) return false;
+            p += t->len[k];
+            if (k + 1 == t->nTok && p < e) return false;       /* folded tail */
+            if (p < e && isWs(*p) == isWs(*b)) return false;    /* run goes on */
+        } else {
+            bool sp = isWs(*p);
+            if (k + 1 == t->nTok && t->nTok == cTmplMaxTok) p = e;
+            else while (p < e && isWs(*p) == sp) ++p;
+            w[*nw].p = b; w[*nw].n = (unsigned)(p - b); ++*nw;
         }
-        if (col < 3) { fputs("Row with <3 columns skipped\n", stderr); continue; }
+    }
+    return p == e;
+}
 
-        for (int i = 0; i < 3; ++i) {
-            if (cell[i][0] == '"') ++cell[i];
-            size_t L = LEN(cell[i]);
-            if (L && cell[i][L-1] == '"') cell[i][L-1] = '\0';
+/* encodes message [m, m+n): template index, parameters appended
+   at *par (the heap offset before the call) */
+static int tmplEncode(MSGSTORE *ms, ARENA *ar, int id, const char *m, size_t n,
+                      long long *par)
+{
+    TOKV tv[cTmplMaxTok];
+    int *last = &ms->last[id & 63], nw;
+    *par = ms->parLen;
+    if (*last) {
+        const TMPL *t = &ms->tp[*last - 1];
+        if (t->id == id && !t->old && tmplFits(t, m, n, tv, &nw)) {
+            for (int j = 0; j < nw; ++j) parPut(ms, tv[j].p, tv[j].n);
+            return *last - 1;
         }
+    }
 
-        char *msg = cell[0], *ts = cell[1], *sid = cell[2];
-        int id = (int)cyvaStrtol(sid, NULL, 10);
-        pushEv(msg, ts, id);
+    int  nTok = msgTokens(m, n, tv), words = 0;
+    int  best = -1, bestEq = -1, bestW = 0;
+
+    for (int j = 0; j < nTok; ++j) words += !isWs(tv[j].p[0]);
+    for (int k = *tmplGroup(ms, id, nTok) - 1; k >= 0 && bestEq < nTok; k = ms->tp[k].next) {
+        const TMPL *t = &ms->tp[k];
+        if (t->old) continue;
+        int eq = 0, eqW = 0;
+        for (int j = 0; j < nTok; ++j)
+            if (!t->tok[j] || tokEq(t->tok[j], t->len[j], tv[j].p, tv[j].n)) {
+                ++eq; eqW += !isWs(tv[j].p[0]);
+            }
+        if (eq > bestEq) { bestEq = eq; bestW = eqW; best = k; }
+    }
+    if (best < 0 || bestW < words * cTmplSim) best = tmplNew(ms, ar, id, tv, nTok, -1);
+    else if (bestEq < nTok)                   best = tmplNew(ms, ar, id, tv, nTok, best);
 
-        char *user = userFromMsg(id, msg);
-        if (!user) continue;
-        ACCT *a = getAcct(user, true); free(user);
+    *last = best + 1;
+    const TMPL *t = &ms->tp[best];
+    for (int j = 0; j < nTok; ++j) if (!t->tok[j]) parPut(ms, tv[j].p, tv[j].n);
+    return best;
+}
 
-        if (id == 4624) a->succ++;
-        else if (id == 4625 || isNtFail(id, msg)) {
-            a->fail++;
-            char *r = failReason(msg);
-            if (r) { pushS(&a->failRS, &a->frCnt, &a->frCap, r); free(r); }
+/* the text of template ti with parameters at par into out[cap];
+   its length, 0 if the parameters run off the heap */
+static size_t msgText(const MSGSTORE *ms, int ti, long long par, char *out, size_t cap)
+{
+    if (ti < 0 || ti >= ms->n || par < 0) return 0;
+    const TMPL *t = &ms->tp[ti];
+    size_t at = 0;
+    for (int k = 0; k < t->nTok; ++k) {
+        const char *s = t->tok[k]; unsigned long long n = t->len[k];
+        if (!s) {
+            n = 0;
+            for (int sh = 0; ; sh += 7) {
+                if (par >= ms->parLen || sh > 28) return 0;
+                unsigned char b = (unsigned char)ms->par[par++];
+                n |= (unsigned long long)(b & 0x7F) << sh;
+                if (!(b & 0x80)) break;
+            }
+            if (n > (unsigned long long)(ms->parLen - par)) return 0;
+            s = ms->par + par; par += (long long)n;
         }
-        if (isLock(id, msg)) {
-            a->locks++;
-            char *tsNice = niceTime(ts);
-            pushS(&a->lockTS, &a->ltCnt, &a->ltCap, tsNice); free(tsNice);
-            if (!a->workstation) a->workstation = workstationFromMsg(msg);
+        if (n > cap - at) return 0;
+        cyvaMemcpy(out + at, s, (size_t)n); at += (size_t)n;
+    }
+    return at;
+}
+
+/* template s of another store, as an index in ‘ms’ (reused when
+   an identical one exists); literals are copied into ‘ar’ */
+static int tmplIntern(MSGSTORE *ms, ARENA *ar, const TMPL *s)
+{
+    for (int k = *tmplGroup(ms, s->id, s->nTok) - 1; k >= 0; k = ms->tp[k].next) {
+        const TMPL *t = &ms->tp[k];
+        int j = 0;
+        for (; j < s->nTok; ++j)
+            if (!t->tok[j] != !s->tok[j] ||
+                (s->tok[j] && !tokEq(t->tok[j], t->len[j], s->tok[j], s->len[j]))) break;
+        if (j == s->nTok) return k;
+    }
+    const char **tok = (const char **)arenaAlloc(ar, s->nTok * sizeof *tok);
+    unsigned    *len = (unsigned *)   arenaAlloc(ar, s->nTok * sizeof *len);
+    for (int j = 0; j < s->nTok; ++j) {
+        tok[j] = NULL; len[j] = s->len[j];
+        if (s->tok[j]) {
+            char *c = (char *)arenaAlloc(ar, s->len[j] + 1);
+            cyvaMemcpy(c, s->tok[j], s->len[j]); c[s->len[j]] = '\0';
+            tok[j] = c;
         }
     }
+    int i = tmplPush(ms, s->id, s->nTok, tok, len);
+    ms->tp[i].old = s->old;
+    return i;
+}
 
-    free(row);
-    fclose(fp);
-    return true;
+static void msgFree(MSGSTORE *ms)
+{
+    free(ms->tp); free(ms->grp); free(ms->par);
+    *ms = (MSGSTORE){0};
 }
 
-/* -- 9.  Reporting helpers -------------------------------- */
-static void listAccountsAll(void)
+/* -- 5.  Per-account stats --------------------------------- */
+static unsigned hashStr(const char *s)           /* FNV-1a */
 {
-    printf("\nAccounts (%d):\n", aCnt);
-    for (int i = 0; i < aCnt; ++i) printf("  %s\n", acct[i].name);
-    puts("");
+    unsigned h = 2166136261u;
+    while (*s) { h ^= (unsigned char)*s++; h *= 16777619u; }
+    return h;
 }
-static void listAccountsLocked(void)
+
+/* -----------------------------------------------------------
+   SSET  –  de-duplicated string set with an occurrence count
+   per value, kept in first-seen order.  Up to cSetSmall
+   values it is a plain vector scanned by hash; past that an
+   open-addressing index (value index + 1) takes over, so
+   setAdd() stays O(1) for accounts that lock out thousands
+   of times.  All storage comes from the dataset arena; grown
+   arrays are simply abandoned there.
+   ----------------------------------------------------------- */
+#define cSetSmall 8
+
+typedef struct {
+    char    **v;  int *cnt;  unsigned *h;  int n, cap;
+    int      *idx;  int idxCap;
+} SSET;
+
+static void *arenaGrow(ARENA *ar, void *old, size_t oldBytes, size_t newBytes)
 {
-    int n = 0; puts("\nLocked-out accounts:");
-    for (int i = 0; i < aCnt; ++i) if (acct[i].locks) {
-        printf("  %s\n", acct[i].name); ++n;
+    void *p = arenaAlloc(ar, newBytes);
+    if (old) cyvaMemcpy(p, old, oldBytes);
+    return p;
+}
+
+static void setReindex(ARENA *ar, SSET *s)
+{
+    s->idxCap = s->idxCap ? s->idxCap * 2 : 32;
+    s->idx    = (int*)arenaCalloc(ar, s->idxCap * sizeof *s->idx);
+
+    unsigned mask = (unsigned)s->idxCap - 1;
+    for (int i = 0; i < s->n; ++i) {
+        unsigned k = s->h[i] & mask;
+        while (s->idx[k]) k = (k + 1) & mask;
+        s->idx[k] = i + 1;
     }
-    if (!n) puts("  (none)");
-    puts("");
 }
-static void showAccount(const char *name)
+
+/* returns the value's index in v[] */
+static int setAdd(ARENA *ar, SSET *s, const char *str, int times)
 {
-    ACCT *a = getAcct(name, false);
-    if (!a) { printf("  \"%s\" not found.\n\n", name); return; }
+    unsigned h = hashStr(str), mask = (unsigned)s->idxCap - 1, k = h & mask;
 
-    printf("\n===== %s =====\n", a->name);
-    printf("Successful logons : %d\n", a->succ);
-    printf("Failed logons     : %d\n", a->fail);
-    printf("Lock-out events   : %d\n", a->locks);
-    printf("Workstation       : %s\n",
-           a->workstation ? a->workstation : "(none)");
+    if (s->idx) {
+        for (; s->idx[k]; k = (k + 1) & mask) {
+            int i = s->idx[k] - 1;
+            if (s->h[i] == h && !CMP(s->v[i], str)) { s->cnt[i] += times; return i; }
+        }
+    } else {
+        for (int i = 0; i < s->n; ++i)
+            if (s->h[i] == h && !CMP(s->v[i], str)) { s->cnt[i] += times; return i; }
+    }
 
-    puts("\nFailure reasons:");
-    if (a->frCnt == 0) puts("  (none)");
-    else
-        for (int i = 0; i < a->frCnt; ++i)
-            printf("  - %s\n", a->failRS[i]);
+    if (s->n == s->cap) {
+        int c  = s->cap ? s->cap * 2 : cSetSmall;
+        s->v   = (char**)   arenaGrow(ar, s->v,   s->n * sizeof *s->v,   c * sizeof *s->v);
+        s->cnt = (int*)     arenaGrow(ar, s->cnt, s->n * sizeof *s->cnt, c * sizeof *s->cnt);
+        s->h   = (unsigned*)arenaGrow(ar, s->h,   s->n * sizeof *s->h,   c * sizeof *s->h);
+        s->cap = c;
+    }
+    s->v[s->n] = arenaStrdup(ar, str); s->cnt[s->n] = times; s->h[s->n] = h;
+    ++s->n;
 
-    puts("\nLock-out timestamps:");
-    if (a->ltCnt == 0) puts("  (none)");
-    else
-        for (int i = 0; i < a->ltCnt; ++i)
-            printf("  - %s\n", a->lockTS[i]);
+    if (s->n > cSetSmall && s->n * 2 > s->idxCap) setReindex(ar, s);
+    else if (s->idx) {
+        for (k = h & mask; s->idx[k]; k = (k + 1) & mask) ;
+        s->idx[k] = s->n;
+    }
+    return s->n - 1;
 }
 
-/* -- 10.  Mini interactive driver ------------------------- */
-static void LogAnalysisMenu(void)
+/* -----------------------------------------------------------
+   TSET  –  SSET's twin for epoch values (lock-out times):
+   first-seen order, count per value, hashed past cSetSmall.
+   ----------------------------------------------------------- */
+typedef struct {
+    long long *v;  int *cnt;  int n, cap;
+    int       *idx;  int idxCap;
+} TSET;
+
+static unsigned hashTime(long long t)
+{ return (unsigned)(((unsigned long long)t * 0x9E3779B97F4A7C15ull) >> 32); }
+
+static void tsetReindex(ARENA *ar, TSET *s)
 {
-    char path[260];
-    printf("\nCSV path: "); fgets(path, sizeof path, stdin);
-    path[CSPRINT(path, "\r\n")] = '\0';
-    if (!*path) { puts("Cancelled.\n"); return; }
+    s->idxCap = s->idxCap ? s->idxCap * 2 : 32;
+    s->idx    = (int*)arenaCalloc(ar, s->idxCap * sizeof *s->idx);
 
-    if (!loadCSV(path)) return;
+    unsigned mask = (unsigned)s->idxCap - 1;
+    for (int i = 0; i < s->n; ++i) {
+        unsigned k = hashTime(s->v[i]) & mask;
+        while (s->idx[k]) k = (k + 1) & mask;
+        s->idx[k] = i + 1;
+    }
+}
 
-    for (;;) {
-        puts("\n== NXLog Log-Analysis ==");
-        puts(" 1  List all accounts");
-        puts(" 2  List locked-out accounts");
-        puts(" 3  Query account");
-        puts(" 0  Back");
-        printf("> ");
+static void tsetAdd(ARENA *ar, TSET *s, long long t, int times)
+{
+    unsigned h = hashTime(t), mask = (unsigned)s->idxCap - 1, k = h & mask;
 
-        int ch = getchar(); while (getchar() != '\n');
-        if (ch == '0') break;
-        if (ch == '1') { listAccountsAll();    continue; }
-        if (ch == '2') { listAccountsLocked(); continue; }
-        if (ch == '3') {
-            char buf[128];
-            printf("Account name: "); fgets(buf, sizeof buf, stdin);
-            buf[CSPRINT(buf, "\r\n")] = '\0';
-            if (*buf) showAccount(buf);
+    if (s->idx) {
+        for (; s->idx[k]; k = (k + 1) & mask)
+            if (s->v[s->idx[k] - 1] == t) { s->cnt[s->idx[k] - 1] += times; return; }
+    } else {
+        for (int i = 0; i < s->n; ++i)
+            if (s->v[i] == t) { s->cnt[i] += times; return; }
+    }
+
+    if (s->n == s->cap) {
+        int c  = s->cap ? s->cap * 2 : cSetSmall;
+        s->v   = (long long*)arenaGrow(ar, s->v,   s->n * sizeof *s->v,   c * sizeof *s->v);
+        s->cnt = (int*)      arenaGrow(ar, s->cnt, s->n * sizeof *s->cnt, c * sizeof *s->cnt);
+        s->cap = c;
+    }
+    s->v[s->n] = t; s->cnt[s->n] = times;
+    ++s->n;
+
+    if (s->n > cSetSmall && s->n * 2 > s->idxCap) tsetReindex(ar, s);
+    else if (s->idx) {
+        for (k = h & mask; s->idx[k]; k = (k + 1) & mask) ;
+        s->idx[k] = s->n;
+    }
+}
+
+/* -----------------------------------------------------------
+   TOPK  –  Space-Saving heavy-hitter summary over at most ‘cap’
+   keys (topCap when first used), so memory is fixed however
+   many distinct keys the input has.  A hash of chained
+   counters finds a key; a min-heap on the counts finds the
+   victim.  An unseen key evicts the smallest counter and
+   inherits its count as ‘err’.  The true count therefore lies
+   in [cnt - err, cnt], err never exceeds total / cap, and every
+   key more frequent than total / cap is guaranteed present.
+   Weighted adds make summaries mergeable (parallel workers).
+   Exact while distinct keys <= cap.
+   ----------------------------------------------------------- */
+#define cTopKey 96                              /* bytes per key, truncating */
+
+static int topCap = 1024;                       /* counters per summary */
+
+typedef struct {
+    char     key[cTopKey];
+    unsigned h;
+    int      cnt, err;
+    int      next, pos;                         /* chain link, heap slot */
+} TOPC;
+
+typedef struct {
+    TOPC     *c;     int n, cap;
+    int      *heap;                             /* counter ids, min cnt first */
+    int      *bucket;  unsigned bMask;          /* chain heads, -1 = empty */
+    long long total;
+} TOPK;
+
+enum { tkAcct, tkWs, tkReason, tkCount };
+
+static void topSwap(TOPK *k, int i, int j)
+{
+    int a = k->heap[i], b = k->heap[j];
+    k->heap[i] = b; k->c[b].pos = i;
+    k->heap[j] = a; k->c[a].pos = j;
+}
+static void topUp(TOPK *k, int i)
+{
+    while (i && k->c[k->heap[i]].cnt < k->c[k->heap[(i - 1) / 2]].cnt) {
+        topSwap(k, i, (i - 1) / 2); i = (i - 1) / 2;
+    }
+}
+static void topDown(TOPK *k, int i)
+{
+    for (;;) {
+        int l = 2 * i + 1, m = i;
+        if (l     < k->n && k->c[k->heap[l]].cnt     < k->c[k->heap[m]].cnt) m = l;
+        if (l + 1 < k->n && k->c[k->heap[l + 1]].cnt < k->c[k->heap[m]].cnt) m = l + 1;
+        if (m == i) return;
+        topSwap(k, i, m); i = m;
+    }
+}
+
+static void topInit(TOPK *k, int cap)
+{
+    unsigned b = 16;
+    while (b < 2u * (unsigned)cap) b <<= 1;
+    k->cap    = cap;
+    k->c      = (TOPC*)xmalloc(k->cap * sizeof *k->c);
+    k->heap   = (int*) xmalloc(k->cap * sizeof *k->heap);
+    k->bucket = (int*) xmalloc(b * sizeof *k->bucket);
+    k->bMask  = b - 1;
+    for (unsigned i = 0; i < b; ++i) k->bucket[i] = -1;
+}
+
+static void topAdd(TOPK *k, const char *key, int w, int e)
+{
+    if (!k->cap) topInit(k, topCap);
+    char kb[cTopKey];
+    cyvaStrcpy_cap(kb, sizeof kb, key);
+    unsigned h = hashStr(kb);
+    k->total += w;
+
+    for (int i = k->bucket[h & k->bMask]; i >= 0; i = k->c[i].next)
+        if (k->c[i].h == h && !CMP(k->c[i].key, kb)) {
+            k->c[i].cnt += w; k->c[i].err += e;
+            topDown(k, k->c[i].pos);
+            return;
+        }
+
+    int  i;
+    bool fresh = k->n < k->cap;
+    if (fresh) {                                /* free counter */
+        i = k->n++;
+        k->heap[i] = i; k->c[i].pos = i;
+        k->c[i].cnt = w; k->c[i].err = e;
+    } else {                                    /* evict the minimum */
+        i = k->heap[0];
+        int *pp = &k->bucket[k->c[i].h & k->bMask];
+        while (*pp != i) pp = &k->c[*pp].next;
+        *pp = k->c[i].next;
+        k->c[i].err = k->c[i].cnt + e;
+        k->c[i].cnt += w;
+    }
+    cyvaStrcpy_cap(k->c[i].key, cTopKey, kb);
+    k->c[i].h    = h;
+    k->c[i].next = k->bucket[h & k->bMask];
+    k->bucket[h & k->bMask] = i;
+    if (fresh) topUp(k, i);                     /* new tail slot */
+    else       topDown(k, 0);                   /* grown root    */
+}
+
+static void topFree(TOPK *k)
+{
+    free(k->c); free(k->heap); free(k->bucket);
+    *k = (TOPK){0};
+}
+
+/* -----------------------------------------------------------
+   IPTRIE  –  failures per source address in a compressed
+   binary radix tree (Patricia trie), one root per family.
+   Addresses are held left-aligned in 128 bits, IPv4 in the
+   top 32 (“::ffff:a.b.c.d” counts as IPv4).  A node covers
+   all addresses sharing its first ‘bits’ bits: leaves are
+   single addresses (bits 32 / 128), inner nodes have two
+   children that part at bit ‘bits’, so there are fewer than
+   two nodes per distinct address however long the shared
+   prefixes.  Every node carries its subtree's failure and
+   address totals, so a prefix is answered by one descent of
+   at most prefix-length steps and grouping by /N visits only
+   the nodes above the /N cut.  Node 0 is unused: a link of 0
+   is no node.
+   ----------------------------------------------------------- */
+typedef struct { unsigned long long hi, lo; } IPKEY;
+
+typedef struct {
+    IPKEY key;                          /* an address in the subtree */
+    int   kid[2];                       /* 0 = leaf                  */
+    int   fails, addrs;                 /* subtree totals            */
+    int   bits;                         /* shared prefix length      */
+} IPNODE;
+
+typedef struct { IPNODE *n; int cnt, cap; int root[2]; } IPTRIE;  /* [0] IPv4, [1] IPv6 */
+
+static int ipMaxBits(int fam) { return fam ? 128 : 32; }
+
+static int clz64(unsigned long long x)           /* x != 0 */
+{
+#if defined(_MSC_VER)
+    unsigned long i;
+#   if defined(_M_X64) || defined(_M_ARM64)
+    _BitScanReverse64(&i, x);
+#   else
+    if (x >> 32) _BitScanReverse(&i, (unsigned)(x >> 32)), i += 32;
+    else         _BitScanReverse(&i, (unsigned)x);
+#   endif
+    return 63 - (int)i;
+#else
+    return __builtin_clzll(x);
+#endif
+}
+
+static int ipBit(const IPKEY *k, int i)
+{
+    return (int)((i < 64 ? k->hi >> (63 - i) : k->lo >> (127 - i)) & 1);
+}
+
+/* first bit where a and b differ, 128 if equal */
+static int ipDiff(const IPKEY *a, const IPKEY *b)
+{
+    unsigned long long x = a->hi ^ b->hi;
+    if (x) return clz64(x);
+    x = a->lo ^ b->lo;
+    return x ? 64 + clz64(x) : 128;
+}
+
+static int ipNode(IPTRIE *t, const IPKEY *k, int bits, int fails, int addrs)
+{
+    if (t->cnt + 1 >= t->cap) {
+        t->cap = t->cap ? t->cap * 2 : 256;
+        t->n   = (IPNODE *)realloc(t->n, t->cap * sizeof *t->n);
+        if (!t->n) { perror("OOM"); exit(1); }
+    }
+    if (!t->cnt) t->cnt = 1;                     /* skip node 0 */
+    t->n[t->cnt] = (IPNODE){ *k, { 0, 0 }, fails, addrs, bits };
+    return t->cnt++;
+}
+
+/* ‘w’ more failures from address k of family ‘fam’ */
+static void ipAdd(IPTRIE *t, int fam, const IPKEY *k, int w)
+{
+    int max = ipMaxBits(fam), path[130], np = 0, at = t->root[fam], up = 0, side = 0, d = 0;
+    while (at) {
+        d = ipDiff(k, &t->n[at].key);
+        if (d > max) d = max;
+        if (d < t->n[at].bits) break;            /* parts inside this prefix */
+        path[np++] = at;
+        if (t->n[at].bits == max) {              /* known address */
+            for (int i = 0; i < np; ++i) t->n[path[i]].fails += w;
+            return;
+        }
+        up = at; side = ipBit(k, t->n[at].bits); at = t->n[at].kid[side];
+    }
+    int top = ipNode(t, k, max, w, 1);
+    if (at) {                                    /* split above ‘at’ */
+        int leaf = top, b = ipBit(k, d);
+        top = ipNode(t, k, d, t->n[at].fails + w, t->n[at].addrs + 1);
+        t->n[top].kid[b] = leaf; t->n[top].kid[!b] = at;
+    }
+    if (up) t->n[up].kid[side] = top; else t->root[fam] = top;
+    for (int i = 0; i < np; ++i) { t->n[path[i]].fails += w; t->n[path[i]].addrs++; }
+}
+
+/* the node holding exactly the addresses under k/len, 0 if none */
+static int ipFind(const IPTRIE *t, int fam, const IPKEY *k, int len)
+{
+    int at = t->root[fam];
+    while (at && t->n[at].bits < len) at = t->n[at].kid[ipBit(k, t->n[at].bits)];
+    return at && ipDiff(k, &t->n[at].key) >= len ? at : 0;
+}
+
+/* the /cut networks under ‘at’ into out[] (each a node) */
+static void ipGroups(const IPTRIE *t, int at, int cut, int *out, int *n)
+{
+    if (!at) return;
+    if (t->n[at].bits >= cut) { out[(*n)++] = at; return; }
+    ipGroups(t, t->n[at].kid[0], cut, out, n);
+    ipGroups(t, t->n[at].kid[1], cut, out, n);
+}
+
+static bool ipParse4(const char *s, const char *e, unsigned *out)
+{
+    unsigned a = 0; int parts = 0;
+    while (s < e && parts < 4) {
+        unsigned v = 0; const char *d = s;
+        while (s < e && *s >= '0' && *s <= '9' && s - d < 3) v = v * 10 + (unsigned)(*s++ - '0');
+        if (s == d || v > 255) return false;
+        a = a << 8 | v; ++parts;
+        if (s < e && (*s != '.' || parts == 4)) return false;
+        if (s < e) ++s;
+    }
+    *out = a;
+    return parts == 4 && s == e && e[-1] != '.';
+}
+
+/* “10.20.1.5”, “2001:db8::5”, “[fe80::1%4]” into *k; returns
+   the family (0 IPv4, 1 IPv6), -1 if not an address */
+static int ipParse(const char *s, size_t n, IPKEY *k)
+{
+    const char *e = s + n;
+    if (s < e && *s == '[') { ++s; if (e > s && e[-1] == ']') --e; }
+    for (const char *p = s; p < e; ++p) if (*p == '%') { e = p; break; }
+    if (s == e) return -1;
+
+    unsigned v4;
+    bool colon = false;
+    for (const char *p = s; p < e; ++p) colon |= *p == ':';
+    if (!colon) {
+        if (!ipParse4(s, e, &v4)) return -1;
+        k->hi = (unsigned long long)v4 << 32; k->lo = 0;
+        return 0;
+    }
+
+    unsigned g[8]; int ng = 0, gap = -1;
+    const char *p = s;
+    if (p[0] == ':') { if (e - p < 2 || p[1] != ':') return -1; gap = 0; p += 2; }
+    while (p < e) {
+        const char *q = p; bool dot = false;
+        while (q < e && *q != ':') dot |= *q++ == '.';
+        if (dot) {                               /* embedded IPv4 tail */
+            if (q != e || ng > 6 || !ipParse4(p, q, &v4)) return -1;
+            g[ng++] = v4 >> 16; g[ng++] = v4 & 0xFFFF;
+            break;
+        }
+        if (q == p || q - p > 4 || ng == 8) return -1;
+        unsigned x = 0;
+        for (; p < q; ++p) {
+            int c = tolower((unsigned char)*p);
+            if      (c >= '0' && c <= '9') x = x << 4 | (unsigned)(c - '0');
+            else if (c >= 'a' && c <= 'f') x = x << 4 | (unsigned)(c - 'a' + 10);
+            else return -1;
+        }
+        g[ng++] = x;
+        if (q == e) break;
+        p = q + 1;
+        if (p < e && *p == ':') { if (gap >= 0) return -1; gap = ng; ++p; }
+        else if (p == e) return -1;              /* trailing ‘:’ */
+    }
+    if (gap < 0 ? ng != 8 : ng > 7) return -1;
+
+    unsigned full[8] = {0};
+    int tail = gap < 0 ? 0 : ng - gap;
+    for (int i = 0; i < ng - tail; ++i) full[i] = g[i];
+    for (int i = 0; i < tail; ++i) full[8 - tail + i] = g[gap + i];
+    k->hi = k->lo = 0;
+    for (int i = 0; i < 4; ++i) { k->hi = k->hi << 16 | full[i]; k->lo = k->lo << 16 | full[i + 4]; }
+    if (!k->hi && k->lo >> 32 == 0xFFFF) {       /* IPv4-mapped */
+        k->hi = k->lo << 32; k->lo = 0;
+        return 0;
+    }
+    return 1;
+}
+
+/* k/len with the host bits cleared, “/len” left off for a
+   single address; IPv6 zero runs shortened to “::” */
+static const char *ipFmt(int fam, IPKEY k, int len, char *out, size_t cap)
+{
+    if (len < 64)  { k.lo = 0; k.hi &= len ? ~0ULL << (64 - len) : 0; }
+    else if (len < 128) k.lo &= len > 64 ? ~0ULL << (128 - len) : 0;
+    size_t o = 0;
+    if (!fam) {
+        unsigned a = (unsigned)(k.hi >> 32);
+        o = (size_t)snprintf(out, cap, "%u.%u.%u.%u", a >> 24, a >> 16 & 255, a >> 8 & 255, a & 255);
+    } else {
+        unsigned g[8]; int z0 = -1, zn = 0;
+        for (int i = 0; i < 8; ++i)
+            g[i] = (unsigned)((i < 4 ? k.hi >> (48 - 16 * i) : k.lo >> (48 - 16 * (i - 4))) & 0xFFFF);
+        for (int i = 0, j; i < 8; i = j + 1) {   /* longest run of 0s */
+            for (j = i; j < 8 && !g[j]; ++j) ;
+            if (j - i > zn && j - i > 1) { z0 = i; zn = j - i; }
+        }
+        for (int i = 0; i < 8 && o < cap; ++i) {
+            if (i == z0) { o += (size_t)snprintf(out + o, cap - o, "::"); i += zn - 1; continue; }
+            o += (size_t)snprintf(out + o, cap - o, "%s%x", o && out[o - 1] != ':' ? ":" : "", g[i]);
+        }
+    }
+    if (len < ipMaxBits(fam) && o < cap) snprintf(out + o, cap - o, "/%d", len);
+    return out;
+}
+
+struct BFWIN;
+struct SPWIN;
+
+typedef struct {
+    char  *name;
+    unsigned hash;                      /* hashStr(name), for reindex */
+    int    succ, fail, locks;
+    char  *workstation;
+    TSET   lockTS;                      /* distinct lock-out times    */
+    SSET   failRS;                      /* distinct failure reasons   */
+    struct BFWIN *bf;                   /* brute-force window, lazy   */
+    int    sess, sessOpen, sessLost;    /* logon sessions closed, still
+                                           open, timed out            */
+    long long sessSec, sessMax;         /* their total / longest time */
+} ACCT;
+
+/* -----------------------------------------------------------
+   COLMAP  –  which CSV column feeds each role, matched by name
+   from the header line (NXLog to_csv writes field names).
+   at[] holds column index + 1, 0 = not in this file.  ‘need’
+   is how many leading columns the splitter has to delimit, so
+   cells past the last mapped one are never looked at; ‘core’
+   is how many a row needs for message, time and id.  need == 0
+   (no header read) means the fixed Message,EventTime,EventID
+   layout.
+   ----------------------------------------------------------- */
+enum { colMsg, colTime, colId, colHost, colIp, colWs, colRoles };
+#define cMaxCols 64
+
+typedef struct { unsigned char at[colRoles], need, core; } COLMAP;
+
+/* -----------------------------------------------------------
+   LOGTAB  –  one set of event + account tables.  ‘lg’ is the
+   loaded dataset the reports read; parallel loader workers
+   each fill a private LOGTAB that is merged into ‘lg’ after.
+   acct[] stays dense for iteration; aIdx[] is an open-
+   addressing (linear probe) index over it holding acct
+   index + 1, 0 = empty slot.  It doubles at half load.
+   Strings and sets live in ‘ar’; freeTab() releases the lot.
+   With ‘aggOnly’ set no events are kept, only aggregates.
+   ‘live’ (follow mode) feeds rows parsed after the initial load
+   straight to the detectors, as aggregate-only streams do.
+   ‘src’ interns failure sources (workstations as \\NAME,
+   addresses bare) with their failure counts, ‘host’ the
+   logging computers with their event counts.  ‘col’ is the
+   column layout of the file being parsed into the table.
+   ----------------------------------------------------------- */
+typedef struct {
+    EVCOLS ev;                              /* raw events          */
+    MSGSTORE msg;                           /* their messages      */
+    ACCT  *acct;  int aCnt,  aCap;
+    int   *aIdx;  int aIdxCap;
+    ARENA  ar;
+    bool   aggOnly, live;
+    int   *tIdx;  int tIdxCnt;              /* event indices by time */
+    struct BFALERT *bfAl;  int bfCnt, bfCap; /* brute-force alerts  */
+    SSET   src;                                /* failure sources     */
+    IPTRIE net;                                /* failures by address */
+    SSET   host;                               /* logging computers   */
+    COLMAP col;                                /* input column layout */
+    struct SPWIN  **spw;   int spwCap;         /* spray sketch/source */
+    struct SPALERT *spAl;  int spCnt, spCap;   /* spray alerts        */
+    TOPK   top[tkCount];                       /* failure heavy hitters */
+    struct SSOPEN *ss;  int ssCnt, ssCap;      /* open logon sessions */
+    long long ssNow, ssSwept;                  /* newest logon/off, last sweep */
+} LOGTAB;
+
+static LOGTAB lg;
+
+static void bfFeed(LOGTAB *t, int ai, long long when);
+static void spFeed(LOGTAB *t, int si, int ai, long long when);
+static void ssFeed(LOGTAB *t, int id, int ai, int host, unsigned long long lid, long long when);
+static void runDetectors(LOGTAB *t);
+
+static void pushEv(LOGTAB *t, const char *m, size_t mLen, long long ts, int id,
+                   int acctIdx, int kind, int ws, int ip, int host, unsigned long long lid)
+{
+    if (t->aggOnly) return;
+    EVCOLS *c = &t->ev;
+    evReserve(c, c->n + 1);
+    int i = c->n++;
+    c->tmpl[i] = tmplEncode(&t->msg, &t->ar, id, m, mLen, &c->par[i]);
+    c->msgLen[i] = (unsigned)mLen;
+    c->t[i]    = ts;
+    c->acct[i] = acctIdx; c->kind[i] = (unsigned char)kind;
+    c->id[i]   = (unsigned short)(id >= 0 && id <= 0xFFFF ? id : 0);
+    c->ws[i]   = ws;  c->ip[i] = ip;  c->host[i] = host;
+    c->lid[i]  = lid;
+}
+
+static void acctReindex(LOGTAB *t)
+{
+    free(t->aIdx);
+    t->aIdxCap = t->aIdxCap ? t->aIdxCap * 2 : 256;
+    t->aIdx    = (int*)xcalloc(t->aIdxCap, sizeof *t->aIdx);
+
+    unsigned mask = (unsigned)t->aIdxCap - 1;
+    for (int i = 0; i < t->aCnt; ++i) {
+        unsigned k = t->acct[i].hash & mask;
+        while (t->aIdx[k]) k = (k + 1) & mask;
+        t->aIdx[k] = i + 1;
+    }
+}
+
+static ACCT *getAcct(LOGTAB *t, const char *n, bool mk)
+{
+    unsigned h = hashStr(n), mask = (unsigned)t->aIdxCap - 1, k = h & mask;
+
+    if (t->aIdxCap)
+        for (; t->aIdx[k]; k = (k + 1) & mask) {
+            ACCT *a = &t->acct[t->aIdx[k] - 1];
+            if (a->hash == h && !CMP(a->name, n)) return a;
+        }
+
+    if (!mk) return NULL;
+    if (t->aCnt == t->aCap) { t->aCap = t->aCap ? t->aCap * 2 : 64;
+                              t->acct = (ACCT*)realloc(t->acct, t->aCap * sizeof *t->acct); }
+    if ((t->aCnt + 1) * 2 > t->aIdxCap) {       /* grow, then re-probe */
+        acctReindex(t);
+        mask = (unsigned)t->aIdxCap - 1;
+        for (k = h & mask; t->aIdx[k]; k = (k + 1) & mask) ;
+    }
+    t->aIdx[k] = t->aCnt + 1;
+
+    ACCT *a = &t->acct[t->aCnt++];
+    a->name = arenaStrdup(&t->ar, n);
+    a->hash = h;
+    a->succ = a->fail = a->locks = 0;
+    a->workstation = NULL;
+    a->lockTS = (TSET){0};
+    a->failRS = (SSET){0};
+    a->bf     = NULL;
+    a->sess = a->sessOpen = a->sessLost = 0;
+    a->sessSec = a->sessMax = 0;
+    return a;
+}
+/* -- 6.  message-parsing helpers --------------------------- */
+static size_t userFromMsg(int id, const MSGF *mf, char *out, size_t cap)
+{
+    switch (id) {
+    case 4740:  /* lock-out */
+        return fieldToken(msgField(mf, mkSecLockedOut, mkAccountName),
+                          out, cap);
+
+    case 4625: { /* failed logon */
+        size_t n = fieldToken(msgField(mf, mkSecLogonFailed, mkAccountName), out, cap);
+        return (n && CMP(out, "-")) ? n : 0;     /* ignore “-” */
+    }
+
+    case 4624:  /* success */
+        return fieldToken(msgField(mf, mkSecNewLogon, mkAccountName), out, cap);
+
+    case 4776: case 4771: {                     /* NTLM / Kerberos */
+        size_t n = fieldToken(msgField(mf, -1, mkLogonAccount), out, cap);
+        if (n || id == 4776) return n;          /* 4771: Account Name */
+        return fieldToken(msgField(mf, -1, mkAccountName), out, cap);
+    }
+
+    case 4634: case 4647:                       /* logoff (Subject) */
+        return fieldToken(msgField(mf, -1, mkAccountName), out, cap);
+
+    default:
+        return 0;
+    }
+}
+
+static size_t failReason(const MSGF *mf, char *out, size_t cap)
+{
+    size_t n = fieldPhrase(msgField(mf, -1, mkFailureReason), out, cap);
+    if (n) return n;
+
+    n = fieldPhrase(msgField(mf, -1, mkErrorCode), out, cap);
+    if (n) return n;
+
+    return fieldPhrase(msgField(mf, -1, mkStatus), out, cap);
+}
+
+static size_t workstationFromMsg(const MSGF *mf, char *out, size_t cap)
+{
+    size_t n = fieldToken(msgField(mf, -1, mkCallerComputer), out, cap); if (n) return n;
+    n = fieldToken(msgField(mf, -1, mkSourceWorkstation), out, cap);          if (n) return n;
+    return fieldToken(msgField(mf, -1, mkWorkstationName), out, cap);
+}
+
+/* failure source keys: workstation as “\\NAME”, address as is */
+static size_t sourceWs(const MSGF *mf, char *out, size_t cap)
+{
+    char w[128]; size_t n = workstationFromMsg(mf, w, sizeof w), i = 0;
+    while (i < n && w[i] == '\\') ++i;
+    if (i == n || !CMP(w + i, "-") || cap < 3) return 0;
+    out[0] = out[1] = '\\';
+    cyvaStrcpy_cap(out + 2, cap - 2, w + i);
+    return LEN(out);
+}
+/* 4625 names the peer “Source Network Address”, 4771 “Client
+   Address” */
+static size_t sourceIp(const MSGF *mf, char *out, size_t cap)
+{
+    size_t n = fieldToken(msgField(mf, -1, mkSourceAddress), out, cap);
+    if (!n || !CMP(out, "-"))
+        n = fieldToken(msgField(mf, -1, mkClientAddress), out, cap);
+    return (n && CMP(out, "-")) ? n : 0;
+}
+
+/* Kerberos reports IPv4 peers mapped (“::ffff:10.1.2.3”); keep
+   the plain form so they share a source key with 4625 rows */
+static size_t unmapV4(char *s, size_t n)
+{
+    unsigned v4;
+    if (n <= 7 || !ci_memmem(s, 7, "::ffff:") || !ipParse4(s + 7, s + n, &v4))
+        return n;
+    cyvaStrcpy_cap(s, n + 1, s + 7);
+    return n - 7;
+}
+
+/* Logon ID of the session a 4624 opens (New Logon) or a
+   4634/4647 closes (Subject): “0x1FEF7”, or the older
+   “(0x0,0x1FEF7)” high,low form; 0 if none */
+static unsigned long long logonIdFromMsg(int id, const MSGF *mf)
+{
+    const MSGFIELD *f = msgField(mf, id == 4624 ? mkSecNewLogon : -1, mkLogonId);
+    unsigned long long hi = 0, v = 0;
+    for (size_t i = 0; f && i < f->vLen; ++i) {
+        int c = tolower((unsigned char)f->v[i]);
+        if (c == 'x' && !v)            continue;           /* “0x” */
+        if (c >= '0' && c <= '9')      v = v << 4 | (unsigned)(c - '0');
+        else if (c >= 'a' && c <= 'f') v = v << 4 | (unsigned)(c - 'a' + 10);
+        else if (c == ',')             { hi = v; v = 0; }
+        else if (c != '(' && c != ')') break;
+    }
+    return hi << 32 | v;
+}
+
+/* NTSTATUS-style value is zero (“0x0”, “0”) */
+static bool codeIsZero(const MSGFIELD *f)
+{
+    if (!f) return false;
+    size_t i = 0;
+    if (f->vLen > 1 && f->v[0] == '0' && (f->v[1] == 'x' || f->v[1] == 'X')) i = 2;
+    if (i == f->vLen) return false;
+    for (; i < f->vLen && !isspace((unsigned char)f->v[i]); ++i)
+        if (f->v[i] != '0') return false;
+    return true;
+}
+
+static bool isLock(int id, const MSGF *mf)
+{
+    if (id == 4740) return true;
+    if (id == 4625 || id == 4776 || id == 4771)
+        return (mf->mark & ((MKSET)1 << mkLockedOutText |
+                            (MKSET)1 << mkLockedOutCode)) != 0;
+    return false;
+}
+static bool isNtFail(int id, const MSGF *mf)
+{
+    return (id == 4776 || id == 4771) &&
+           !(codeIsZero(msgField(mf, -1, mkErrorCode)) ||
+             codeIsZero(msgField(mf, -1, mkStatus)));
+}
+
+/* -- 7.  getline-compat for MSVC --------------------------- */
+#if defined(_MSC_VER)
+static ssize_t getline_ms(char **buf, size_t *cap, FILE *fp)
+{
+    if (!*buf || !*cap) { *cap = 256; *buf = (char*)malloc(*cap); }
+    size_t n = 0; int ch;
+    while ((ch = fgetc(fp)) != EOF) {
+        if (n + 2 >= *cap) { *cap <<= 1; *buf = (char*)realloc(*buf, *cap); }
+        (*buf)[n++] = (char)ch;
+        if (ch == '\n') break;
+    }
+    if (n == 0 && ch == EOF) return -1;
+    (*buf)[n] = '\0'; return (ssize_t)n;
+}
+#   define GETLINE getline_ms
+#else
+#   define GETLINE getline
+#endif
+
+/* -- 8.  read-only file mapping ---------------------------- */
+/* -----------------------------------------------------------
+   SRC  –  a sequential byte source over a file that may be
+   compressed.  The kind comes from the magic bytes, not the
+   name: 1F 8B is gzip, 28 B5 2F FD is zstd.  Built with
+   CYVA_HAVE_ZLIB / CYVA_HAVE_ZSTD the data is inflated in
+   process.  Without them the file is piped through the
+   gzip / zstd command-line tools, which then decompress in
+   their own process.  srcRead() fills the whole buffer unless
+   the input ends.
+   ----------------------------------------------------------- */
+#if defined(_MSC_VER)
+#   define POPEN  _popen
+#   define PCLOSE _pclose
+#else
+#   define POPEN  popen
+#   define PCLOSE pclose
+#endif
+
+enum { srcRaw, srcGzip, srcZstd };
+
+typedef struct {
+    int    kind;
+    FILE  *fp;                          /* raw / zstd input / tool pipe */
+    bool   piped, err;
+#if defined(CYVA_HAVE_ZLIB)
+    gzFile gz;
+#endif
+#if defined(CYVA_HAVE_ZSTD)
+    ZSTD_DStream  *zs;
+    ZSTD_inBuffer  ib;
+    char          *in;  size_t inCap;
+    size_t         zLeft;               /* 0 = at a frame boundary */
+#endif
+} SRC;
+
+static int fileKind(const char *path)
+{
+    unsigned char mg[4] = {0};
+    FILE *fp = fopen(path, "rb");
+    if (!fp) return srcRaw;
+    size_t n = fread(mg, 1, sizeof mg, fp);
+    fclose(fp);
+    if (n >= 2 && mg[0] == 0x1F && mg[1] == 0x8B) return srcGzip;
+    if (n == 4 && mg[0] == 0x28 && mg[1] == 0xB5 && mg[2] == 0x2F && mg[3] == 0xFD) return srcZstd;
+    return srcRaw;
+}
+
+/* “tool -dc -- 'path'” with the path quoted for the shell */
+static bool toolCmd(char *cmd, size_t cap, const char *tool, const char *path)
+{
+    size_t n = 0;
+    for (const char *c = tool; *c && n + 1 < cap; ) cmd[n++] = *c++;
+#if defined(_MSC_VER)
+    if (path[CSPRINT(path, "\"")]) return false;
+    const char *q = "\"";
+#else
+    const char *q = "'";
+#endif
+    if (n + 1 < cap) cmd[n++] = *q;
+    for (const char *c = path; *c; ++c) {
+#if !defined(_MSC_VER)
+        if (*c == '\'') {                       /* ' -> '\'' */
+            const char *e = "'\\''";
+            while (*e && n + 1 < cap) cmd[n++] = *e++;
+            continue;
+        }
+#endif
+        if (n + 1 < cap) cmd[n++] = *c;
+    }
+    if (n + 2 >= cap) return false;
+    cmd[n++] = *q; cmd[n] = '\0';
+    return true;
+}
+
+static bool srcOpen(SRC *s, const char *path)
+{
+    *s = (SRC){0};
+    s->kind = fileKind(path);
+    s->fp   = fopen(path, "rb");
+    if (!s->fp) { perror(path); return false; }
+    if (s->kind == srcRaw) return true;
+
+#if defined(CYVA_HAVE_ZLIB)
+    if (s->kind == srcGzip) {
+        fclose(s->fp); s->fp = NULL;
+        if (!(s->gz = gzopen(path, "rb"))) { perror(path); return false; }
+        gzbuffer(s->gz, 1u << 20);
+        return true;
+    }
+#endif
+#if defined(CYVA_HAVE_ZSTD)
+    if (s->kind == srcZstd) {
+        s->zs    = ZSTD_createDStream();
+        s->inCap = ZSTD_DStreamInSize();
+        s->in    = (char *)xmalloc(s->inCap);
+        s->ib    = (ZSTD_inBuffer){ s->in, 0, 0 };
+        if (!s->zs || ZSTD_isError(ZSTD_initDStream(s->zs))) {
+            fprintf(stderr, "%s: zstd init failed\n", path); return false;
+        }
+        return true;
+    }
+#endif
+    char cmd[600];                               /* fall back: the CLI tool */
+    fclose(s->fp); s->fp = NULL;
+    if (!toolCmd(cmd, sizeof cmd, s->kind == srcGzip ? "gzip -dc -- " : "zstd -dcq -- ", path)) {
+        fprintf(stderr, "%s: cannot quote path for the shell\n", path); return false;
+    }
+    s->fp = POPEN(cmd, "r"); s->piped = true;
+    if (!s->fp) { perror(cmd); return false; }
+    return true;
+}
+
+static size_t srcRead(SRC *s, char *buf, size_t n)
+{
+#if defined(CYVA_HAVE_ZLIB)
+    if (s->gz) {
+        size_t got = 0;
+        while (got < n) {
+            unsigned want = n - got > (1u << 30) ? 1u << 30 : (unsigned)(n - got);
+            int r = gzread(s->gz, buf + got, want);
+            int ze = Z_OK;
+            if (r == 0) gzerror(s->gz, &ze);     /* truncated stream? */
+            if (r < 0 || ze != Z_OK) { s->err = true; break; }
+            if (r == 0) break;
+            got += (size_t)r;
+        }
+        return got;
+    }
+#endif
+#if defined(CYVA_HAVE_ZSTD)
+    if (s->zs) {
+        ZSTD_outBuffer ob = { buf, n, 0 };
+        while (ob.pos < ob.size) {
+            if (s->ib.pos == s->ib.size) {
+                s->ib.size = fread(s->in, 1, s->inCap, s->fp); s->ib.pos = 0;
+                if (!s->ib.size) { if (s->zLeft) s->err = true; break; }
+            }
+            s->zLeft = ZSTD_decompressStream(s->zs, &ob, &s->ib);
+            if (ZSTD_isError(s->zLeft)) { s->err = true; break; }
+        }
+        return ob.pos;
+    }
+#endif
+    size_t got = fread(buf, 1, n, s->fp);
+    if (got < n && ferror(s->fp)) s->err = true;
+    return got;
+}
+
+static bool srcClose(SRC *s, const char *name)
+{
+#if defined(CYVA_HAVE_ZLIB)
+    if (s->gz) gzclose(s->gz);
+#endif
+#if defined(CYVA_HAVE_ZSTD)
+    if (s->zs) ZSTD_freeDStream(s->zs);
+    free(s->in);
+#endif
+    if (s->fp) {
+        if (s->piped) { if (PCLOSE(s->fp)) s->err = true; }
+        else fclose(s->fp);
+    }
+    if (s->err) fprintf(stderr, "%s: read or decompression failed\n", name);
+    bool ok = !s->err;
+    *s = (SRC){0};
+    return ok;
+}
+
+/* -----------------------------------------------------------
+   mapFile  –  maps the whole CSV read-only so rows can be
+   parsed in place.  If the OS refuses (pipe, FIFO, exotic FS)
+   the file is slurped into one heap block instead, as are
+   compressed files (inflated through SRC); callers see
+   the same {p, n} view either way.  Events keep no views into
+   the input, so callers unmap as soon as it is parsed.
+   ----------------------------------------------------------- */
+typedef struct {
+    const char *p;  size_t n;   /* bytes of the file               */
+    bool        heap;           /* true = slurped, free() on unmap */
+#if defined(_MSC_VER)
+    HANDLE      hFile, hMap;
+#endif
+} LOGMAP;
+
+static bool slurpFile(FILE *fp, LOGMAP *m)
+{
+    size_t cap = 1 << 20, n = 0, got;
+    char  *buf = (char *)xmalloc(cap);
+    while ((got = fread(buf + n, 1, cap - n, fp)) > 0) {
+        n += got;
+        if (n == cap) { cap <<= 1; buf = (char *)realloc(buf, cap);
+                        if (!buf) { perror("OOM"); exit(1); } }
+    }
+    m->p = buf; m->n = n; m->heap = true;
+    return true;
+}
+
+static bool inflateFile(const char *path, LOGMAP *m)
+{
+    SRC s;
+    if (!srcOpen(&s, path)) { srcClose(&s, path); return false; }
+    size_t cap = 1 << 20, n = 0, got;
+    char  *buf = (char *)xmalloc(cap);
+    while ((got = srcRead(&s, buf + n, cap - n)) > 0) {
+        n += got;
+        if (n == cap) { cap <<= 1; buf = (char *)realloc(buf, cap);
+                        if (!buf) { perror("OOM"); exit(1); } }
+    }
+    m->p = buf; m->n = n; m->heap = true;
+    if (srcClose(&s, path)) return true;
+    free(buf); m->p = NULL; m->n = 0;
+    return false;
+}
+
+static bool mapFile(const char *path, LOGMAP *m)
+{
+    m->p = NULL; m->n = 0; m->heap = false;
+    if (fileKind(path) != srcRaw) return inflateFile(path, m);
+
+#if defined(_MSC_VER)
+    m->hFile = CreateFileA(path, GENERIC_READ,
+                           FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                           NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (m->hFile == INVALID_HANDLE_VALUE) { perror(path); return false; }
+
+    LARGE_INTEGER sz;
+    if (GetFileSizeEx(m->hFile, &sz) && sz.QuadPart > 0 &&
+        (m->hMap = CreateFileMappingA(m->hFile, NULL, PAGE_READONLY, 0, 0, NULL))) {
+        m->p = (const char *)MapViewOfFile(m->hMap, FILE_MAP_READ, 0, 0, 0);
+        if (m->p) { m->n = (size_t)sz.QuadPart; return true; }
+        CloseHandle(m->hMap);
+    }
+    CloseHandle(m->hFile);
+#else
+    FILE *fp = fopen(path, "rb");
+    if (!fp) { perror(path); return false; }
+
+    struct stat st;
+    if (!fstat(fileno(fp), &st) && S_ISREG(st.st_mode) && st.st_size > 0) {
+        void *v = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE,
+                       fileno(fp), 0);
+        if (v != MAP_FAILED) {
+            madvise(v, (size_t)st.st_size, MADV_SEQUENTIAL);
+            fclose(fp);
+            m->p = (const char *)v; m->n = (size_t)st.st_size;
+            return true;
+        }
+    }
+#endif
+
+#if defined(_MSC_VER)
+    FILE *fp = fopen(path, "rb");                /* fall back: one read */
+    if (!fp) { perror(path); return false; }
+#endif
+    bool ok = slurpFile(fp, m);
+    fclose(fp);
+    return ok;
+}
+
+static void unmapFile(LOGMAP *m)
+{
+    if (!m->p) return;
+    if (m->heap) free((void *)m->p);
+    else {
+#if defined(_MSC_VER)
+        UnmapViewOfFile(m->p); CloseHandle(m->hMap); CloseHandle(m->hFile);
+#else
+        munmap((void *)m->p, m->n);
+#endif
+    }
+    m->p = NULL; m->n = 0;
+}
+
+/* -----------------------------------------------------------
+   listInputs  –  expands a load path into CSV file names: a
+   directory means its *.csv, *.csv.gz and *.csv.zst files, a
+   name with * or ? is a wildcard, anything else is taken as
+   one file.  Names are returned sorted (xstrdup'ed, caller
+   frees) so multi-file loads merge in a stable order.
+   ----------------------------------------------------------- */
+static int cmpName(const void *a, const void *b)
+{ return CMP(*(char *const *)a, *(char *const *)b); }
+
+static bool isCsvName(const char *s)
+{
+    static const char *const ext[] = { ".csv", ".csv.gz", ".csv.zst" };
+    size_t n = LEN(s);
+    for (int i = 0; i < 3; ++i) {
+        size_t k = LEN(ext[i]);
+        if (n > k && ci_memmem(s + n - k, k, ext[i])) return true;
+    }
+    return false;
+}
+
+static void addName(char ***v, int *n, int *cap, const char *s)
+{
+    if (*n == *cap) { *cap = *cap ? *cap * 2 : 16;
+                      *v   = (char**)realloc(*v, *cap * sizeof **v); }
+    (*v)[(*n)++] = xstrdup(s);
+}
+
+#if defined(_MSC_VER)
+static char *lastChr(const char *s, int ch)               /* portable strrchr  */
+{ char *r = NULL; while (s && *s) { if (*s == ch) r = (char *)s; ++s; } return r; }
+#endif
+
+static int listInputs(const char *path, char ***out)
+{
+    char **v = NULL; int n = 0, cap = 0;
+    char   pat[520];
+    bool   wild = path[CSPRINT(path, "*?")] != '\0';
+
+#if defined(_MSC_VER)
+    DWORD attr = GetFileAttributesA(path);
+    bool  dir  = attr != INVALID_FILE_ATTRIBUTES && (attr & FILE_ATTRIBUTE_DIRECTORY);
+    if (!dir && !wild) { addName(&v, &n, &cap, path); *out = v; return n; }
+
+    cyvaStrcpy(pat, path);
+    if (dir) cyvaStrcat(pat, "\\*");
+
+    char  base[520]; cyvaStrcpy(base, pat);      /* directory part + sep */
+    char *sep = lastChr(base, '\\'), *fs = lastChr(base, '/');
+    if (fs > sep) sep = fs;
+    if (sep) sep[1] = '\0'; else base[0] = '\0';
+
+    WIN32_FIND_DATAA fd;
+    HANDLE h = FindFirstFileA(pat, &fd);
+    if (h != INVALID_HANDLE_VALUE) {
+        do {
+            if (fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) continue;
+            char full[520]; cyvaStrcpy(full, base); cyvaStrcat(full, fd.cFileName);
+            if (!dir || isCsvName(full)) addName(&v, &n, &cap, full);
+        } while (FindNextFileA(h, &fd));
+        FindClose(h);
+    }
+#else
+    struct stat st;
+    bool dir = !stat(path, &st) && S_ISDIR(st.st_mode);
+    if (!dir && !wild) { addName(&v, &n, &cap, path); *out = v; return n; }
+
+    cyvaStrcpy(pat, path);
+    if (dir) cyvaStrcat(pat, "/*");
+
+    glob_t g;
+    if (!glob(pat, 0, NULL, &g)) {
+        for (size_t i = 0; i < g.gl_pathc; ++i)
+            if (!stat(g.gl_pathv[i], &st) && S_ISREG(st.st_mode) &&
+                (!dir || isCsvName(g.gl_pathv[i])))
+                addName(&v, &n, &cap, g.gl_pathv[i]);
+        globfree(&g);
+    }
+#endif
+    if (n) qsort(v, n, sizeof *v, cmpName);
+    *out = v;
+    return n;
+}
+
+/* -- 9.  thread shim --------------------------------------- */
+#if defined(_MSC_VER)
+typedef HANDLE THREAD;
+#   define THREAD_FN(name)  static DWORD WINAPI name(LPVOID arg)
+#   define THREAD_RET       return 0
+static bool thrStart(THREAD *t, LPTHREAD_START_ROUTINE fn, void *arg)
+{ *t = CreateThread(NULL, 0, fn, arg, 0, NULL); return *t != NULL; }
+static long atomicNext(volatile long *p) { return InterlockedIncrement(p) - 1; }
+typedef CRITICAL_SECTION   MUTEX;
+typedef CONDITION_VARIABLE COND;
+static void mtxInit(MUTEX *m)   { InitializeCriticalSection(m); }
+static void mtxFree(MUTEX *m)   { DeleteCriticalSection(m); }
+static void mtxLock(MUTEX *m)   { EnterCriticalSection(m); }
+static void mtxUnlock(MUTEX *m) { LeaveCriticalSection(m); }
+static void cvInit(COND *c)     { InitializeConditionVariable(c); }
+static void cvFree(COND *c)     { (void)c; }
+static void cvWait(COND *c, MUTEX *m) { SleepConditionVariableCS(c, m, INFINITE); }
+static void cvWake(COND *c)     { WakeAllConditionVariable(c); }
+static double nowSec(void)
+{
+    LARGE_INTEGER f, t; QueryPerformanceFrequency(&f); QueryPerformanceCounter(&t);
+    return (double)t.QuadPart / (double)f.QuadPart;
+}
+static void thrJoin(THREAD t) { WaitForSingleObject(t, INFINITE); CloseHandle(t); }
+static int  cpuCount(void)
+{ SYSTEM_INFO si; GetSystemInfo(&si); return (int)si.dwNumberOfProcessors; }
+static bool waitInput(int ms)                   /* console key within ms */
+{
+    for (; ms > 0; ms -= 50) { if (_kbhit()) return true; Sleep(50); }
+    return _kbhit() != 0;
+}
+#else
+typedef pthread_t THREAD;
+#   define THREAD_FN(name)  static void *name(void *arg)
+#   define THREAD_RET       return NULL
+static bool thrStart(THREAD *t, void *(*fn)(void *), void *arg)
+{ return pthread_create(t, NULL, fn, arg) == 0; }
+static long atomicNext(volatile long *p) { return __atomic_fetch_add(p, 1, __ATOMIC_RELAXED); }
+typedef pthread_mutex_t MUTEX;
+typedef pthread_cond_t  COND;
+static void mtxInit(MUTEX *m)   { pthread_mutex_init(m, NULL); }
+static void mtxFree(MUTEX *m)   { pthread_mutex_destroy(m); }
+static void mtxLock(MUTEX *m)   { pthread_mutex_lock(m); }
+static void mtxUnlock(MUTEX *m) { pthread_mutex_unlock(m); }
+static void cvInit(COND *c)     { pthread_cond_init(c, NULL); }
+static void cvFree(COND *c)     { pthread_cond_destroy(c); }
+static void cvWait(COND *c, MUTEX *m) { pthread_cond_wait(c, m); }
+static void cvWake(COND *c)     { pthread_cond_broadcast(c); }
+static double nowSec(void)
+{ struct timespec t; clock_gettime(CLOCK_MONOTONIC, &t); return t.tv_sec + t.tv_nsec / 1e9; }
+static void thrJoin(THREAD t) { pthread_join(t, NULL); }
+static int  cpuCount(void)
+{ long n = sysconf(_SC_NPROCESSORS_ONLN); return n > 0 ? (int)n : 1; }
+static bool waitInput(int ms)                   /* stdin readable within ms */
+{
+    fd_set r; FD_ZERO(&r); FD_SET(0, &r);
+    struct timeval tv = { ms / 1000, (ms % 1000) * 1000 };
+    return select(1, &r, NULL, NULL, &tv) > 0;
+}
+#endif
+
+/* -- 10.  CSV loader (zero-copy) --------------------------- */
+static int parseId(const char *s, size_t n)      /* bounded cyvaStrtol */
+{
+    size_t i = 0; int sign = 1, v = 0;
+    while (i < n && isspace((unsigned char)s[i])) ++i;
+    if (i < n && (s[i] == '+' || s[i] == '-')) { if (s[i] == '-') sign = -1; ++i; }
+    while (i < n && s[i] >= '0' && s[i] <= '9') v = v * 10 + (s[i++] - '0');
+    return v * sign;
+}
+
+/* -----------------------------------------------------------
+   Structural scanner  –  classifies 64 bytes at a time into
+   bit masks of quotes, cell separators (',' '\t') and
+   newlines.  It uses AVX2 or SSE2 when the CPU has them (picked
+   once by scanInit()) and a scalar loop otherwise.  The
+   in-quote region of a block is the prefix XOR of its quote
+   mask, inverted when the previous block ended inside quotes.
+   Separators and newlines under it are dropped; what remains
+   are the row ends and cell boundaries that the splitters walk
+   bit by bit instead of byte by byte.
+   ----------------------------------------------------------- */
+typedef struct { unsigned long long q, sep, nl; } SMASK;
+
+static void maskScalar(const char *p, SMASK *m)
+{
+    unsigned long long q = 0, s = 0, n = 0;
+    for (int i = 0; i < 64; ++i) {
+        unsigned long long b = 1ull << i;
+        if      (p[i] == '"')                   q |= b;
+        else if (p[i] == ',' || p[i] == '\t')   s |= b;
+        else if (p[i] == '\n')                  n |= b;
+    }
+    m->q = q; m->sep = s; m->nl = n;
+}
+
+#if defined(CYVA_SSE2)
+static void maskSse2(const char *p, SMASK *m)
+{
+    const __m128i dq = _mm_set1_epi8('"'), cm = _mm_set1_epi8(','),
+                  tb = _mm_set1_epi8('\t'), nl = _mm_set1_epi8('\n');
+    unsigned long long q = 0, s = 0, n = 0;
+    for (int i = 0; i < 4; ++i) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(p + 16 * i));
+        q |= (unsigned long long)(unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(v, dq)) << (16 * i);
+        s |= (unsigned long long)(unsigned)_mm_movemask_epi8(
+                 _mm_or_si128(_mm_cmpeq_epi8(v, cm), _mm_cmpeq_epi8(v, tb))) << (16 * i);
+        n |= (unsigned long long)(unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(v, nl)) << (16 * i);
+    }
+    m->q = q; m->sep = s; m->nl = n;
+}
+
+#   if defined(__GNUC__)
+#       define AVX2_FN __attribute__((target("avx2")))
+#   else
+#       define AVX2_FN
+#   endif
+AVX2_FN static void maskAvx2(const char *p, SMASK *m)
+{
+    const __m256i dq = _mm256_set1_epi8('"'), cm = _mm256_set1_epi8(','),
+                  tb = _mm256_set1_epi8('\t'), nl = _mm256_set1_epi8('\n');
+    unsigned long long q = 0, s = 0, n = 0;
+    for (int i = 0; i < 2; ++i) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(p + 32 * i));
+        q |= (unsigned long long)(unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, dq)) << (32 * i);
+        s |= (unsigned long long)(unsigned)_mm256_movemask_epi8(
+                 _mm256_or_si256(_mm256_cmpeq_epi8(v, cm), _mm256_cmpeq_epi8(v, tb))) << (32 * i);
+        n |= (unsigned long long)(unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, nl)) << (32 * i);
+    }
+    m->q = q; m->sep = s; m->nl = n;
+}
+
+static bool cpuHasAvx2(void)
+{
+#   if defined(_MSC_VER)
+    int r[4];
+    __cpuid(r, 0);
+    if (r[0] < 7) return false;
+    __cpuid(r, 1);
+    if (!(r[2] & (1 << 27)) || !(r[2] & (1 << 28))) return false; /* OSXSAVE, AVX */
+    if ((_xgetbv(0) & 6) != 6) return false;                       /* OS saves YMM */
+    __cpuidex(r, 7, 0);
+    return (r[1] & (1 << 5)) != 0;
+#   else
+    return __builtin_cpu_supports("avx2");
+#   endif
+}
+#endif
+
+static void (*maskFn)(const char *, SMASK *) = maskScalar;
+
+static void scanInit(void)                       /* before any worker */
+{
+#if defined(CYVA_SSE2)
+    maskFn = cpuHasAvx2() ? maskAvx2 : maskSse2;
+#endif
+}
+
+/* masks of [p, p+n), n <= 64; bytes past n never match */
+static void blockMasks(const char *p, size_t n, SMASK *m)
+{
+    if (n == 64) { maskFn(p, m); return; }
+    char tmp[64] = {0};
+    cyvaMemcpy(tmp, p, n);
+    maskFn(tmp, m);
+}
+
+static unsigned long long prefixXor(unsigned long long x)
+{
+    x ^= x << 1;  x ^= x << 2;  x ^= x << 4;
+    x ^= x << 8;  x ^= x << 16; x ^= x << 32;
+    return x;
+}
+
+static int ctz64(unsigned long long x)           /* x != 0 */
+{
+#if defined(_MSC_VER)
+    unsigned long i;
+#   if defined(_M_X64) || defined(_M_ARM64)
+    _BitScanForward64(&i, x);
+#   else
+    if ((unsigned)x) _BitScanForward(&i, (unsigned)x);
+    else { _BitScanForward(&i, (unsigned)(x >> 32)); i += 32; }
+#   endif
+    return (int)i;
+#else
+    return __builtin_ctzll(x);
+#endif
+}
+
+static void parserInit(void) { acBuild(); scanInit(); }
+
+/* -----------------------------------------------------------
+   Column mapping  –  header names per role, first match wins
+   and case is ignored.  A header naming none of the message,
+   time and id columns is taken for the old fixed layout;
+   otherwise a missing one is reported and left empty.
+   ----------------------------------------------------------- */
+static const COLMAP kColLegacy = { { 1, 2, 3 }, 3, 3 };
+
+static const char *const kColName[colRoles][2] = {
+    [colMsg]  = { "Message" },
+    [colTime] = { "EventTime",       "TimeCreated" },
+    [colId]   = { "EventID" },
+    [colHost] = { "Hostname",        "Computer" },
+    [colIp]   = { "IpAddress" },
+    [colWs]   = { "WorkstationName" },
+};
+
+static bool nameIs(const char *s, size_t n, const char *name)
+{
+    size_t i = 0;
+    for (; i < n && name[i]; ++i)
+        if (tolower((unsigned char)s[i]) != tolower((unsigned char)name[i])) return false;
+    return i == n && !name[i];
+}
+
+/* maps the header row [p, e) (line break excluded) into *c */
+static void readColumns(COLMAP *c, const char *p, const char *e)
+{
+    *c = (COLMAP){0};
+    const char *beg = p; bool inQ = false;
+    for (int col = 0; col < cMaxCols; ++p) {
+        if (p < e && *p == '"') { inQ = !inQ; continue; }
+        if (p < e && (inQ || (*p != ',' && *p != '\t'))) continue;
+
+        const char *b = beg, *x = p;             /* trim blanks, quotes */
+        while (b < x && (isspace((unsigned char)*b) || *b == '"')) ++b;
+        while (x > b && (isspace((unsigned char)x[-1]) || x[-1] == '"')) --x;
+        for (int r = 0; r < colRoles; ++r)
+            for (int k = 0; k < 2 && kColName[r][k]; ++k)
+                if (!c->at[r] && nameIs(b, (size_t)(x - b), kColName[r][k]))
+                    c->at[r] = (unsigned char)(col + 1);
+        ++col;
+        if (p >= e) break;
+        beg = p + 1;
+    }
+
+    if (!c->at[colMsg] && !c->at[colTime] && !c->at[colId]) {
+        unsigned char h = c->at[colHost], i = c->at[colIp], w = c->at[colWs];
+        *c = kColLegacy;
+        c->at[colHost] = h; c->at[colIp] = i; c->at[colWs] = w;
+    }
+    for (int r = 0; r < colRoles; ++r) {
+        if (r <= colId && !c->at[r])
+            fprintf(stderr, "No %s column in the header; left empty.\n", kColName[r][0]);
+        if (c->at[r] > c->need) c->need = c->at[r];
+        if (r <= colId && c->at[r] > c->core) c->core = c->at[r];
+    }
+}
+
+/* failure source from a column: workstation as “\\NAME”,
+   address as is; empty or “-” gives 0 */
+static size_t colSource(const char *v, size_t n, bool ws, char *out, size_t cap)
+{
+    while (ws && n && *v == '\\') { ++v; --n; }
+    if (!n || (n == 1 && *v == '-') || n + 3 > cap) return 0;
+    size_t at = ws ? 2 : 0;
+    out[0] = out[1] = '\\';
+    cyvaMemcpy(out + at, v, n); out[at + n] = '\0';
+    return at + n;
+}
+
+/* -----------------------------------------------------------
+   parseRow  –  one logical row [r, e) without its line break.
+   sep[] holds the first nSep (<= cm->need) cell separators
+   found by the scanner; only the mapped columns are sliced.
+   ----------------------------------------------------------- */
+static void parseRow(LOGTAB *t, const COLMAP *cm, const char *r, const char *e,
+                     const char *const *sep, int nSep)
+{
+    if (nSep + 1 < cm->core) {
+        fprintf(stderr, "Row with <%d columns skipped\n", cm->core);
+        return;
+    }
+
+    const char *cell[colRoles]; size_t cLen[colRoles];
+    for (int k = 0; k < colRoles; ++k) {
+        int i = cm->at[k] - 1;
+        if (i < 0 || i > nSep) { cell[k] = ""; cLen[k] = 0; continue; }
+        cell[k] = i ? sep[i - 1] + 1 : r;
+        cLen[k] = (size_t)((i < nSep ? sep[i] : e) - cell[k]);
+        if (cLen[k] && cell[k][0] == '"') { ++cell[k]; --cLen[k]; }
+        if (cLen[k] && cell[k][cLen[k]-1] == '"') --cLen[k];
+    }
+
+    const char *msg = cell[colMsg], *ts = cell[colTime];
+    size_t mLen = cLen[colMsg], tLen = cLen[colTime];
+    int id = parseId(cell[colId], cLen[colId]);
+    long long when = parseTime(ts, tLen);
+
+    int host = -1;
+    if (cLen[colHost] && cLen[colHost] < 256) {
+        char h[256];
+        cyvaMemcpy(h, cell[colHost], cLen[colHost]); h[cLen[colHost]] = '\0';
+        host = setAdd(&t->ar, &t->host, h, 1);
+    }
+
+    if (id != 4624 && id != 4625 && id != 4740 && id != 4776 && id != 4771 &&
+        id != 4634 && id != 4647) {
+        pushEv(t, msg, mLen, when, id, -1, 0, -1, -1, host, 0); /* nothing to aggregate */
+        return;
+    }
+
+    MSGF mf;
+    msgTokenize(msg, mLen, &mf);
+
+    char user[128];
+    if (!userFromMsg(id, &mf, user, sizeof user)) {
+        pushEv(t, msg, mLen, when, id, -1, 0, -1, -1, host, 0);
+        return;
+    }
+    ACCT *a = getAcct(t, user, true);
+    int kind = 0, ws = -1, ip = -1;
+    unsigned long long lid = id == 4624 || id == 4634 || id == 4647
+                             ? logonIdFromMsg(id, &mf) : 0;
+
+    if (id == 4624) { a->succ++; kind |= evSucc; }
+    else if (id == 4625 || isNtFail(id, &mf)) {
+        a->fail++; kind |= evFail;
+        char rsn[256];
+        topAdd(&t->top[tkAcct], user, 1, 0);
+        if (failReason(&mf, rsn, sizeof rsn)) {
+            setAdd(&t->ar, &a->failRS, rsn, 1);
+            topAdd(&t->top[tkReason], rsn, 1, 0);
+        }
+        if (colSource(cell[colWs], cLen[colWs], true, rsn, sizeof rsn) ||
+            sourceWs(&mf, rsn, sizeof rsn)) {
+            ws = setAdd(&t->ar, &t->src, rsn, 1);
+            topAdd(&t->top[tkWs], rsn, 1, 0);
+        }
+        size_t n = colSource(cell[colIp], cLen[colIp], false, rsn, sizeof rsn);
+        if (n || (n = sourceIp(&mf, rsn, sizeof rsn))) {
+            n = unmapV4(rsn, n);
+            IPKEY k; int fam = ipParse(rsn, n, &k);
+            ip = setAdd(&t->ar, &t->src, rsn, 1);
+            if (fam >= 0) ipAdd(&t->net, fam, &k, 1);
+        }
+    }
+    if (isLock(id, &mf)) {
+        a->locks++; kind |= evLock;
+        tsetAdd(&t->ar, &a->lockTS, when, 1);
+        if (!a->workstation) {
+            char w[128];
+            if (workstationFromMsg(&mf, w, sizeof w))
+                a->workstation = arenaStrdup(&t->ar, w);
+        }
+    }
+    int ai = (int)(a - t->acct);
+    if ((t->aggOnly || t->live) && (kind & evFail)) {
+        bfFeed(t, ai, when);
+        if (ws >= 0) spFeed(t, ws, ai, when);
+        if (ip >= 0) spFeed(t, ip, ai, when);
+    }
+    if ((t->aggOnly || t->live) && lid) ssFeed(t, id, ai, host, lid, when);
+    pushEv(t, msg, mLen, when, id, ai, kind, ws, ip, host, lid);
+}
+
+/* -----------------------------------------------------------
+   parseRows  –  splits [buf, buf+len) into logical rows.  A
+   newline only ends a row outside quotes (messages carry
+   embedded line breaks).  Returns the bytes consumed; a
+   trailing partial row is left unconsumed unless ‘eof’.
+   ‘buf’ must start a row (outside quotes).
+   ----------------------------------------------------------- */
+static void rowDone(LOGTAB *t, const COLMAP *cm, const char *r, const char *re,
+                    const char *const *sep, int nSep)
+{
+    while (re > r && (re[-1] == '\n' || re[-1] == '\r')) --re;
+    if (re > r) parseRow(t, cm, r, re, sep, nSep);
+}
+
+static size_t parseRows(LOGTAB *t, const char *buf, size_t len, bool eof)
+{
+    const COLMAP *cm = t->col.need ? &t->col : &kColLegacy;
+    const char *r = buf, *sep[cMaxCols];         /* row start, first separators */
+    int  nSep = 0;
+    unsigned long long inQ = 0;                  /* all ones: block starts quoted */
+
+    for (size_t off = 0; off < len; off += 64) {
+        SMASK m;
+        blockMasks(buf + off, len - off < 64 ? len - off : 64, &m);
+        unsigned long long in = prefixXor(m.q) ^ inQ;
+        inQ = 0 - (in >> 63);
+
+        for (unsigned long long st = (m.sep | m.nl) & ~in; st; st &= st - 1) {
+            const char *c = buf + off + ctz64(st);
+            if (*c != '\n') { if (nSep < cm->need) sep[nSep++] = c; continue; }
+            rowDone(t, cm, r, c, sep, nSep);
+            r = c + 1; nSep = 0;
+        }
+    }
+    if (r < buf + len) {
+        if (!eof) return (size_t)(r - buf);
+        rowDone(t, cm, r, buf + len, sep, nSep);
+    }
+    return len;
+}
+
+/* -- 11.  parallel loader ---------------------------------- */
+/* -----------------------------------------------------------
+   The body is cut into one byte range per worker.  A newline
+   ends a row only when the number of quotes since the header
+   is even, so:
+     pass 1  each worker counts the quotes in its range;
+     prefix  XOR of those parities = quote state at each cut;
+     snap    each cut moves forward to the next real row end;
+     pass 2  each worker parses its rows into a private LOGTAB;
+     merge   tables are folded into ‘lg’ in file order, which
+             reproduces the single-threaded result exactly.
+   ----------------------------------------------------------- */
+#define cParMinBytes   (8u << 20)     /* below this: one thread   */
+#define cParChunk      (4u << 20)     /* min bytes per worker     */
+#define cParMaxThreads 64
+
+typedef struct {
+    const char *beg, *end;            /* byte range               */
+    bool        odd;                  /* pass 1: odd quote count  */
+    LOGTAB      tab;                  /* pass 2: private tables   */
+} PARJOB;
+
+THREAD_FN(parCountQuotes)
+{
+    PARJOB *j = (PARJOB *)arg;
+    size_t  len = (size_t)(j->end - j->beg);
+    unsigned long long x = 0;                    /* XOR of quote masks */
+    for (size_t off = 0; off < len; off += 64) {
+        SMASK m;
+        blockMasks(j->beg + off, len - off < 64 ? len - off : 64, &m);
+        x ^= m.q;
+    }
+    x ^= x >> 32; x ^= x >> 16; x ^= x >> 8; x ^= x >> 4; x ^= x >> 2; x ^= x >> 1;
+    j->odd = x & 1;
+    THREAD_RET;
+}
+
+THREAD_FN(parParse)
+{
+    PARJOB *j = (PARJOB *)arg;
+    parseRows(&j->tab, j->beg, (size_t)(j->end - j->beg), true);
+    THREAD_RET;
+}
+
+static void runJobs(PARJOB *job, int n, bool parse)
+{
+    THREAD th[cParMaxThreads]; bool ok[cParMaxThreads];
+    for (int k = 1; k < n; ++k)
+        ok[k] = parse ? thrStart(&th[k], parParse, &job[k])
+                      : thrStart(&th[k], parCountQuotes, &job[k]);
+    if (parse) parParse(&job[0]); else parCountQuotes(&job[0]);
+    for (int k = 1; k < n; ++k) {
+        if (ok[k]) thrJoin(th[k]);
+        else if (parse) parParse(&job[k]); else parCountQuotes(&job[k]);
+    }
+}
+
+/* first row start at or after ‘c’, given the quote state there */
+static const char *snapToRow(const char *c, const char *e, bool inQ)
+{
+    if (c[-1] == '\n' && !inQ) return c;
+    for (; c < e; ++c) {
+        if (*c == '"') inQ = !inQ;
+        else if (*c == '\n' && !inQ) return c + 1;
+    }
+    return e;
+}
+
+static void freeTab(LOGTAB *t)
+{
+    evFree(&t->ev); msgFree(&t->msg);
+    free(t->acct); free(t->aIdx); free(t->tIdx); free(t->bfAl);
+    free(t->spw);  free(t->spAl); free(t->ss); free(t->net.n);
+    for (int k = 0; k < tkCount; ++k) topFree(&t->top[k]);
+    arenaFree(&t->ar);
+    *t = (LOGTAB){0};
+}
+
+static void mergeTab(LOGTAB *dst, LOGTAB *src)
+{
+    int *remap = (int*)xmalloc((src->aCnt + 1) * sizeof *remap);
+
+    for (int i = 0; i < src->aCnt; ++i) {
+        ACCT *s = &src->acct[i], *d = getAcct(dst, s->name, true);
+        remap[i] = (int)(d - dst->acct);
+        d->succ += s->succ; d->fail += s->fail; d->locks += s->locks;
+        if (!d->workstation && s->workstation)
+            d->workstation = arenaStrdup(&dst->ar, s->workstation);
+        for (int k = 0; k < s->failRS.n; ++k)
+            setAdd(&dst->ar, &d->failRS, s->failRS.v[k], s->failRS.cnt[k]);
+        for (int k = 0; k < s->lockTS.n; ++k)
+            tsetAdd(&dst->ar, &d->lockTS, s->lockTS.v[k], s->lockTS.cnt[k]);
+    }
+
+    for (int k = 0; k < tkCount; ++k)
+        for (int i = 0; i < src->top[k].n; ++i)
+            topAdd(&dst->top[k], src->top[k].c[i].key,
+                   src->top[k].c[i].cnt, src->top[k].c[i].err);
+
+    for (int i = 1; i < src->net.cnt; ++i) {    /* leaves: one address each */
+        const IPNODE *x = &src->net.n[i];
+        if (!x->kid[0]) ipAdd(&dst->net, x->bits == 128, &x->key, x->fails);
+    }
+
+    int *srcMap = (int*)xmalloc((src->src.n + 1) * sizeof *srcMap);
+    for (int i = 0; i < src->src.n; ++i)
+        srcMap[i] = setAdd(&dst->ar, &dst->src, src->src.v[i], src->src.cnt[i]);
+    int *hostMap = (int*)xmalloc((src->host.n + 1) * sizeof *hostMap);
+    for (int i = 0; i < src->host.n; ++i)
+        hostMap[i] = setAdd(&dst->ar, &dst->host, src->host.v[i], src->host.cnt[i]);
+
+    MSGSTORE *dm = &dst->msg; const MSGSTORE *sm = &src->msg;
+    int *tmplMap = (int*)xmalloc((sm->n + 1) * sizeof *tmplMap);
+    for (int i = 0; i < sm->n; ++i) tmplMap[i] = tmplIntern(dm, &dst->ar, &sm->tp[i]);
+    long long parAt = dm->parLen;
+    if (sm->parLen) {
+        if (dm->parLen + sm->parLen > dm->parCap) {
+            dm->parCap = dm->parLen + sm->parLen;
+            dm->par    = (char *)realloc(dm->par, (size_t)dm->parCap);
+            if (!dm->par) { perror("OOM"); exit(1); }
+        }
+        cyvaMemcpy(dm->par + dm->parLen, sm->par, (size_t)sm->parLen);
+        dm->parLen += sm->parLen;
+    }
+
+    EVCOLS *d = &dst->ev; const EVCOLS *s = &src->ev;
+    int at = d->n, n = s->n;
+    if (n) {
+        evReserve(d, at + n);
+        cyvaMemcpy(d->msgLen + at, s->msgLen, n * sizeof *s->msgLen);
+        cyvaMemcpy(d->id     + at, s->id,     n * sizeof *s->id);
+        cyvaMemcpy(d->t      + at, s->t,      n * sizeof *s->t);
+        cyvaMemcpy(d->kind   + at, s->kind,   n * sizeof *s->kind);
+        cyvaMemcpy(d->lid    + at, s->lid,    n * sizeof *s->lid);
+        for (int i = 0; i < n; ++i) d->acct[at + i] = s->acct[i] >= 0 ? remap[s->acct[i]]   : -1;
+        for (int i = 0; i < n; ++i) d->ws[at + i]   = s->ws[i]   >= 0 ? srcMap[s->ws[i]]    : -1;
+        for (int i = 0; i < n; ++i) d->ip[at + i]   = s->ip[i]   >= 0 ? srcMap[s->ip[i]]    : -1;
+        for (int i = 0; i < n; ++i) d->host[at + i] = s->host[i] >= 0 ? hostMap[s->host[i]] : -1;
+        for (int i = 0; i < n; ++i) d->tmpl[at + i] = tmplMap[s->tmpl[i]];
+        for (int i = 0; i < n; ++i) d->par[at + i]  = s->par[i] + parAt;
+        d->n = at + n;
+    }
+    free(remap); free(srcMap); free(hostMap); free(tmplMap);
+}
+
+static void parseParallel(LOGTAB *dst, const char *p, const char *e)
+{
+    size_t len = (size_t)(e - p);
+    int n = cpuCount();
+    if ((size_t)n > len / cParChunk) n = (int)(len / cParChunk);
+    if (n > cParMaxThreads) n = cParMaxThreads;
+    if (len < cParMinBytes || n < 2) { parseRows(dst, p, len, true); return; }
+
+    PARJOB *job = (PARJOB *)xmalloc(n * sizeof *job);
+    for (int k = 0; k < n; ++k) {
+        job[k].beg = p + len / n * k;
+        job[k].end = k + 1 < n ? p + len / n * (k + 1) : e;
+        job[k].tab = (LOGTAB){0};
+        job[k].tab.col = dst->col;
+    }
+    runJobs(job, n, false);
+
+    bool inQ = job[0].odd;                       /* state at cut k */
+    for (int k = 1; k < n; ++k) {
+        bool odd = job[k].odd;
+        job[k].beg = snapToRow(job[k].beg, e, inQ);
+        job[k - 1].end = job[k].beg;
+        inQ ^= odd;
+    }
+    runJobs(job, n, true);
+
+    for (int k = 0; k < n; ++k) { mergeTab(dst, &job[k].tab); freeTab(&job[k].tab); }
+    free(job);
+}
+
+/* maps the header line into *c; first byte after it, NULL if
+   there is none */
+static const char *skipHeader(const LOGMAP *m, COLMAP *c)
+{
+    const char *p = m->p, *e = m->p + m->n;
+    while (p < e && *p != '\n') ++p;
+    if (p == e) return NULL;
+    readColumns(c, m->p, p > m->p && p[-1] == '\r' ? p - 1 : p);
+    return p + 1;
+}
+
+/* just past the last newline outside quotes in [p, e), or p */
+static const char *lastRowEnd(const char *p, const char *e)
+{
+    const char *r = p; size_t len = (size_t)(e - p);
+    unsigned long long inQ = 0;
+    for (size_t off = 0; off < len; off += 64) {
+        SMASK m;
+        blockMasks(p + off, len - off < 64 ? len - off : 64, &m);
+        unsigned long long in = prefixXor(m.q) ^ inQ;
+        inQ = 0 - (in >> 63);
+        for (unsigned long long nl = m.nl & ~in; nl; nl &= nl - 1)
+            r = p + off + ctz64(nl) + 1;
+    }
+    return r;
+}
+
+/* With ‘used’ (follow mode) a trailing row that is still being
+   written is left out and *used = bytes consumed. */
+static bool loadCSVUpTo(const char *path, long long *used)
+{
+    parserInit();                                /* before any worker */
+    LOGMAP m;
+    if (!mapFile(path, &m)) return false;
+
+    const char *p = skipHeader(&m, &lg.col), *e = m.p + m.n;
+    if (!p) { unmapFile(&m); return false; }
+    if (used) { e = lastRowEnd(p, e); *used = (long long)(e - m.p); }
+
+    parseParallel(&lg, p, e);
+    runDetectors(&lg);
+    unmapFile(&m);                               /* events hold no views */
+    return true;
+}
+
+static bool loadSource(const char *path, bool stream);
+
+/* compressed files cannot be mapped: pipelined inflate instead */
+static bool loadCSV(const char *path)
+{
+    return fileKind(path) == srcRaw ? loadCSVUpTo(path, NULL) : loadSource(path, false);
+}
+
+/* -----------------------------------------------------------
+   loadFiles  –  many CSVs (one per DC per day, say): a pool of
+   up to cpuCount() workers pulls files off a shared counter,
+   and each file is parsed whole into its own LOGTAB.  The
+   tables are then merged into ‘lg’ in name order; mergeTab()
+   sums the counters and takes the union of failure reasons,
+   lock-out times and sources.  The first workstation seen in
+   name order wins.  The result does not depend on which worker
+   took which file.
+   ----------------------------------------------------------- */
+typedef struct {
+    const char *path;
+    LOGMAP      m;
+    bool        ok;
+    LOGTAB      tab;
+} FILEJOB;
+
+typedef struct { FILEJOB *job; long n; volatile long next; } FILEPOOL;
+
+THREAD_FN(fileParse)
+{
+    FILEPOOL *pl = (FILEPOOL *)arg; long i;
+    while ((i = atomicNext(&pl->next)) < pl->n) {
+        FILEJOB *j = &pl->job[i];
+        if (!mapFile(j->path, &j->m)) continue;
+        const char *p = skipHeader(&j->m, &j->tab.col);
+        if (!p) { unmapFile(&j->m); continue; }
+        parseRows(&j->tab, p, (size_t)(j->m.p + j->m.n - p), true);
+        j->ok = true;
+    }
+    THREAD_RET;
+}
+
+static bool loadFiles(char **name, int n)
+{
+    parserInit();
+    FILEJOB *job = (FILEJOB *)xcalloc(n, sizeof *job);
+    for (int i = 0; i < n; ++i) job[i].path = name[i];
+    FILEPOOL pl = { job, n, 0 };
+
+    int nt = cpuCount();
+    if (nt > n) nt = n;
+    if (nt > cParMaxThreads) nt = cParMaxThreads;
+    THREAD th[cParMaxThreads]; bool ok[cParMaxThreads];
+    for (int k = 1; k < nt; ++k) ok[k] = thrStart(&th[k], fileParse, &pl);
+    fileParse(&pl);
+    for (int k = 1; k < nt; ++k) if (ok[k]) thrJoin(th[k]);
+
+    int loaded = 0;
+    for (int i = 0; i < n; ++i) {
+        if (job[i].ok) { mergeTab(&lg, &job[i].tab); unmapFile(&job[i].m); ++loaded; }
+        freeTab(&job[i].tab);
+    }
+    free(job);
+    runDetectors(&lg);
+    printf("Loaded %d of %d files.\n", loaded, n);
+    return loaded > 0;
+}
+
+/* -----------------------------------------------------------
+   Read-ahead reader  –  for inputs that cannot be mapped
+   (pipes) or should not be retained (aggregate-only streams).
+   A reader thread fills a ring of cPipeSlots cStreamBlock
+   buffers with fread() while the parser works on the previous
+   one, so I/O and parsing overlap.  The parser copies any
+   carried partial row plus the next block into a work buffer
+   and parses the complete rows out of it, then drops it, so
+   memory is the ring plus one block whatever the input size.
+   Time the parser spends blocked on the ring vs parsing is
+   reported.
+   ----------------------------------------------------------- */
+#define cStreamBlock  (4u << 20)
+#define cPipeSlots    3
+
+typedef struct {
+    SRC    *src;
+    char   *buf[cPipeSlots];  size_t len[cPipeSlots];
+    long    made, used;                         /* blocks filled / taken */
+    bool    eof, stop;
+    MUTEX   mu;  COND more, room;
+} PIPERD;
+
+/* fills the next free slot; false once the input is exhausted */
+static bool pipeStep(PIPERD *r)
+{
+    int    k = (int)(r->made % cPipeSlots);
+    size_t n = srcRead(r->src, r->buf[k], cStreamBlock);
+
+    mtxLock(&r->mu);
+    r->len[k] = n; r->made++;
+    r->eof = n < cStreamBlock;
+    cvWake(&r->more);
+    mtxUnlock(&r->mu);
+    return n == cStreamBlock;
+}
+
+THREAD_FN(pipeFill)
+{
+    PIPERD *r = (PIPERD *)arg;
+    for (;;) {
+        mtxLock(&r->mu);
+        while (r->made - r->used == cPipeSlots && !r->stop) cvWait(&r->room, &r->mu);
+        bool stop = r->stop;
+        mtxUnlock(&r->mu);
+        if (stop || !pipeStep(r)) break;
+    }
+    THREAD_RET;
+}
+
+static bool loadReader(SRC *src, const char *name)
+{
+    parserInit();
+    PIPERD r = {0};
+    r.src = src;
+    for (int k = 0; k < cPipeSlots; ++k) r.buf[k] = (char *)xmalloc(cStreamBlock);
+    mtxInit(&r.mu); cvInit(&r.more); cvInit(&r.room);
+
+    THREAD th; bool async = thrStart(&th, pipeFill, &r);
+
+    char  *carry = NULL; size_t cLen = 0, cCap = 0;
+    bool   hdr = true;
+    double waited = 0, parsed = 0;
+    long long total = 0;
+
+    for (;;) {
+        double t0 = nowSec();
+        if (!async && !r.eof) pipeStep(&r);      /* no thread: read inline */
+        mtxLock(&r.mu);
+        while (r.made == r.used && !r.eof) cvWait(&r.more, &r.mu);
+        bool  have = r.made > r.used;
+        int   k    = (int)(r.used % cPipeSlots);
+        bool  last = r.eof && r.made == r.used + 1;
+        mtxUnlock(&r.mu);
+        double t1 = nowSec();
+        waited += t1 - t0;
+        if (!have) break;
+
+        size_t len  = cLen + r.len[k];
+        char  *work = (char *)xmalloc(len + 1);
+        cyvaMemcpy(work, carry, cLen);
+        cyvaMemcpy(work + cLen, r.buf[k], r.len[k]);
+        total += (long long)r.len[k];
+
+        mtxLock(&r.mu);                          /* slot is copied: hand it back */
+        r.used++;
+        cvWake(&r.room);
+        mtxUnlock(&r.mu);
+
+        size_t off = 0;
+        if (hdr) {                               /* map header line */
+            while (off < len && work[off] != '\n') ++off;
+            if (off < len) {
+                readColumns(&lg.col, work, off && work[off - 1] == '\r' ? work + off - 1 : work + off);
+                hdr = false; ++off;
+            }
+        }
+        if (!hdr) off += parseRows(&lg, work + off, len - off, last);
+
+        cLen = len - off;                        /* partial row: carry */
+        if (cLen > cCap) { cCap = cLen; carry = (char *)realloc(carry, cCap); }
+        if (cLen) cyvaMemcpy(carry, work + off, cLen);
+        free(work);
+
+        parsed += nowSec() - t1;
+        if (last) break;
+    }
+
+    if (async) {
+        mtxLock(&r.mu); r.stop = true; cvWake(&r.room); mtxUnlock(&r.mu);
+        thrJoin(th);
+    }
+    for (int k = 0; k < cPipeSlots; ++k) free(r.buf[k]);
+    free(carry);
+    mtxFree(&r.mu); cvFree(&r.more); cvFree(&r.room);
+
+    printf("Read %.1f MB from %s: parser waited %.2f s for input, parsed %.2f s (%s-bound).\n",
+           total / 1048576.0, name, waited, parsed,
+           waited > parsed ? "input" : "parse");
+    runDetectors(&lg);                           /* no-op if aggOnly */
+    return !hdr;
+}
+
+/* a file (compressed or not) through the ring; the reader
+   thread is also the one that inflates */
+static bool loadSource(const char *path, bool stream)
+{
+    SRC s;
+    if (!srcOpen(&s, path)) { srcClose(&s, path); return false; }
+    if (s.fp && !s.piped) setvbuf(s.fp, NULL, _IONBF, 0); /* own blocks */
+    lg.aggOnly = stream;
+    bool ok = loadReader(&s, path);
+    return srcClose(&s, path) && ok;
+}
+
+/* aggregate-only pass for inputs bigger than RAM */
+static bool loadCSVStream(const char *path) { return loadSource(path, true); }
+
+/* “|command”: its output, e.g. ssh, read through the ring */
+static bool loadPipe(const char *cmd, bool stream)
+{
+    SRC s = {0};
+    if (!(s.fp = POPEN(cmd, "r"))) { perror(cmd); return false; }
+    s.piped    = true;
+    lg.aggOnly = stream;
+    bool ok = loadReader(&s, cmd);
+    return srcClose(&s, cmd) && ok;
+}
+
+/* closeDataset  –  drops ‘lg’ (tables, templates + arena) */
+static void closeDataset(void) { freeTab(&lg); }
+
+/* file, directory, wildcard, snapshot or “|command”; streamed
+   inputs go one by one */
+static bool isSnapshot(const char *path);
+struct SNFOLLOW;
+static bool loadSnapshot(const char *path, struct SNFOLLOW *fol);
+
+static bool loadPath(const char *path, bool stream)
+{
+    if (*path == '|') return loadPipe(path + 1, stream);
+
+    char **name; int n = listInputs(path, &name);
+    bool ok = false;
+
+    if (!n)               printf("No CSV files match %s\n", path);
+    else if (n == 1 && isSnapshot(name[0])) ok = loadSnapshot(name[0], NULL);
+    else if (stream)      for (int i = 0; i < n; ++i) ok |= loadCSVStream(name[i]);
+    else if (n == 1)      ok = loadCSV(name[0]);  /* split inside the file */
+    else                  ok = loadFiles(name, n);
+
+    for (int i = 0; i < n; ++i) free(name[i]);
+    free(name);
+    return ok;
+}
+
+/* -- 12.  time-range index --------------------------------- */
+/* -----------------------------------------------------------
+   tIdx[] lists event indices ordered by (t, index).  It is built
+   on the first windowed query after a load: exports are usually
+   already in time order (either direction), which is detected
+   in one pass; otherwise the index is qsort()ed once.  A range
+   query is then two binary searches.
+   ----------------------------------------------------------- */
+static const long long *sortT;                  /* qsort context */
+
+static int cmpEvTime(const void *a, const void *b)
+{
+    int i = *(const int *)a, j = *(const int *)b;
+    long long ti = sortT[i], tj = sortT[j];
+    return ti < tj ? -1 : ti > tj ? 1 : (i > j) - (i < j);
+}
+
+static void buildTimeIndex(LOGTAB *t)
+{
+    int n = t->ev.n;
+    if (t->tIdx && t->tIdxCnt == n) return;
+    free(t->tIdx);
+    t->tIdx    = (int*)xmalloc((n + 1) * sizeof *t->tIdx);
+    t->tIdxCnt = n;
+
+    const long long *ts = t->ev.t;              /* count the inversions */
+    int fall = 0, rise = 0;
+    for (int i = 1; i < n; ++i) { fall += ts[i] < ts[i-1]; rise += ts[i] >= ts[i-1]; }
+    bool up = !fall, down = !rise;
+    for (int i = 0; i < n; ++i) t->tIdx[i] = down ? n - 1 - i : i;
+    if (!up && !down) {
+        sortT = ts;
+        qsort(t->tIdx, n, sizeof *t->tIdx, cmpEvTime);
+    }
+}
+
+/* first position in tIdx[] whose time is >= t0 */
+static int timeLowerBound(const LOGTAB *t, long long t0)
+{
+    int lo = 0, hi = t->tIdxCnt;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (t->ev.t[t->tIdx[mid]] < t0) lo = mid + 1; else hi = mid;
+    }
+    return lo;
+}
+
+/* [*from, *to) of tIdx[] covering t0 <= t <= t1 */
+static bool timeRange(LOGTAB *t, long long t0, long long t1, int *from, int *to)
+{
+    if (t->aggOnly) {
+        puts("  Time queries need the raw events; reopen without streaming.");
+        return false;
+    }
+    buildTimeIndex(t);
+    *from = timeLowerBound(t, t0);
+    *to   = t1 == 0x7FFFFFFFFFFFFFFFLL ? t->tIdxCnt : timeLowerBound(t, t1 + 1);
+    return true;
+}
+
+/* -- 13.  brute-force detector ---------------------------- */
+/* -----------------------------------------------------------
+   Each account with failures gets a ring of cBfBuckets epoch
+   buckets, each bfWindow / cBfBuckets seconds wide, plus a
+   running sum.  A failure advances the ring (clearing at most
+   cBfBuckets stale buckets), bumps its bucket and the sum: O(1)
+   per event.  When the sum reaches bfThreshold an alert is
+   raised; the account re-arms once the sum drops below it.
+   The window is bucket-granular, i.e. the last M seconds give
+   or take one bucket.
+
+   Retained datasets are replayed in time order through tIdx[]
+   after each load (so file order and worker count do not
+   matter); aggregate-only streams feed it row by row.
+   ----------------------------------------------------------- */
+#define cBfBuckets 16
+
+static int bfThreshold = 20;                    /* N failures ...     */
+static int bfWindow    = 60;                    /* ... in M seconds   */
+
+typedef struct BFWIN {
+    long long slot[cBfBuckets];                 /* bucket number      */
+    int       cnt [cBfBuckets];
+    long long head;                             /* newest bucket      */
+    int       sum;
+    bool      firing;
+} BFWIN;
+
+typedef struct BFALERT { int acct; long long t; int cnt; } BFALERT;
+
+static void bfFeed(LOGTAB *t, int ai, long long when)
+{
+    if (when == cNoTime) return;
+    ACCT *a = &t->acct[ai];
+    if (!a->bf) {
+        a->bf = (BFWIN*)arenaCalloc(&t->ar, sizeof *a->bf);
+        a->bf->head = cNoTime;
+    }
+    BFWIN    *w = a->bf;
+    long long width = bfWindow > cBfBuckets ? (bfWindow + cBfBuckets - 1) / cBfBuckets : 1;
+    long long s = floorDiv(when, width);
+
+    if (w->head == cNoTime || s > w->head) {     /* advance the ring */
+        long long from = w->head == cNoTime || s - w->head > cBfBuckets
+                         ? s - cBfBuckets + 1 : w->head + 1;
+        for (long long k = from; k <= s; ++k) {
+            int b = (int)(((k % cBfBuckets) + cBfBuckets) % cBfBuckets);
+            w->sum -= w->cnt[b];
+            w->cnt[b] = 0; w->slot[b] = k;
+        }
+        w->head = s;
+    } else if (s <= w->head - cBfBuckets) return; /* older than window */
+
+    int b = (int)(((s % cBfBuckets) + cBfBuckets) % cBfBuckets);
+    w->cnt[b]++; w->sum++;
+
+    if (w->sum >= bfThreshold && !w->firing) {
+        w->firing = true;
+        if (t->bfCnt == t->bfCap) { t->bfCap = t->bfCap ? t->bfCap * 2 : 64;
+                                    t->bfAl  = (BFALERT*)realloc(t->bfAl, t->bfCap * sizeof *t->bfAl); }
+        t->bfAl[t->bfCnt++] = (BFALERT){ ai, when, w->sum };
+    } else if (w->sum < bfThreshold) w->firing = false;
+}
+
+/* -----------------------------------------------------------
+   Password-spray detector  –  one HyperLogLog sketch per
+   failure source (workstation or source address) estimates
+   how many distinct accounts it failed against in the current
+   spWindow-second tumbling window.  A sketch is 2^cHllBits
+   one-byte registers whatever the account count, with ~1.04 /
+   sqrt(2^cHllBits) (≈6.5 %) standard error; small counts use
+   linear counting and are near exact.  The harmonic sum and
+   zero-register count are kept incrementally, so a failure is
+   one hash, one register update and one estimate.  A source
+   whose estimate reaches spThreshold raises one alert per
+   window; the alert keeps the window's final estimate.  A
+   late row from before the current window is dropped rather
+   than restarting the sketch.  Fed alongside the brute-force
+   detector, same replay rules.
+   ----------------------------------------------------------- */
+#define cHllBits 8
+#define cHllRegs (1 << cHllBits)
+
+static int spThreshold = 20;                    /* N accounts ...     */
+static int spWindow    = 3600;                  /* ... in M seconds   */
+
+typedef struct SPWIN {
+    long long     win;                          /* window number      */
+    unsigned char reg[cHllRegs];
+    int           zeros;                        /* registers == 0     */
+    double        inv;                          /* sum of 2^-reg      */
+    int           al;                           /* alert index or -1  */
+} SPWIN;
+
+typedef struct SPALERT { int src; long long t; int est; } SPALERT;
+
+static unsigned long long mix64(unsigned long long x)   /* splitmix64 */
+{
+    x ^= x >> 30; x *= 0xBF58476D1CE4E5B9ull;
+    x ^= x >> 27; x *= 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+static int hllEstimate(const SPWIN *w)
+{
+    const double m = cHllRegs, alpha = 0.7213 / (1.0 + 1.079 / m);
+    double e = alpha * m * m / w->inv;
+    if (e <= 2.5 * m && w->zeros) e = m * log(m / w->zeros);
+    return (int)(e + 0.5);
+}
+
+static void spFeed(LOGTAB *t, int si, int ai, long long when)
+{
+    if (when == cNoTime) return;
+    if (si >= t->spwCap) {
+        int c = t->src.cap > si ? t->src.cap : si + 1;
+        t->spw = (SPWIN**)realloc(t->spw, c * sizeof *t->spw);
+        if (!t->spw) { perror("OOM"); exit(1); }
+        for (int i = t->spwCap; i < c; ++i) t->spw[i] = NULL;
+        t->spwCap = c;
+    }
+    SPWIN *w = t->spw[si];
+    if (!w) w = t->spw[si] = (SPWIN*)arenaCalloc(&t->ar, sizeof *w);
+
+    long long win = floorDiv(when, spWindow);
+    if (!w->inv || win > w->win) {               /* fresh window */
+        for (int i = 0; i < cHllRegs; ++i) w->reg[i] = 0;
+        w->win = win; w->zeros = cHllRegs; w->inv = cHllRegs; w->al = -1;
+    } else if (win < w->win) return;             /* older than window */
+
+    unsigned long long x = mix64(t->acct[ai].hash);
+    int j = (int)(x >> (64 - cHllBits)), r = 1;
+    for (x <<= cHllBits; r <= 64 - cHllBits && !(x >> 63); x <<= 1) ++r;
+    if (r <= w->reg[j]) return;                  /* sketch unchanged */
+
+    if (!w->reg[j]) --w->zeros;
+    w->inv += ldexp(1.0, -r) - ldexp(1.0, -w->reg[j]);
+    w->reg[j] = (unsigned char)r;
+
+    int est = hllEstimate(w);
+    if (w->al >= 0) { t->spAl[w->al].est = est; return; }
+    if (est < spThreshold) return;
+    if (t->spCnt == t->spCap) { t->spCap = t->spCap ? t->spCap * 2 : 64;
+                                t->spAl  = (SPALERT*)realloc(t->spAl, t->spCap * sizeof *t->spAl); }
+    w->al = t->spCnt;
+    t->spAl[t->spCnt++] = (SPALERT){ si, win * spWindow, est };
+}
+
+/* -----------------------------------------------------------
+   Logon sessions  –  a 4624 opens a session under its Logon
+   ID, which is unique per logging computer; the 4634 or 4647
+   carrying the same (host, Logon ID) closes it.  The join is
+   a hash table of the open sessions only (linear probing,
+   backward-shift deletion): a logoff finds its logon in O(1),
+   credits the duration to the logon's account and removes it.
+   A session not closed within ssTimeout seconds is evicted as
+   timed out (logoff lost or never logged), as is one whose
+   key a newer logon reuses.  Stale entries are swept out by a
+   rebuild once per ssTimeout of log time or when the table
+   fills, so it holds about one timeout's worth of logons
+   whatever the input size.  Same replay rules as the
+   detectors above; what is left at the end is still open.
+   ----------------------------------------------------------- */
+static int ssTimeout = 86400;                   /* evict after, seconds */
+
+typedef struct SSOPEN { unsigned long long lid; long long t; int host, acct; } SSOPEN;
+
+static unsigned ssHash(unsigned long long lid, int host)
+{
+    return (unsigned)mix64(lid ^ (unsigned long long)(unsigned)host << 40);
+}
+
+/* slot holding (lid, host), or the free slot it would take */
+static SSOPEN *ssSlot(const LOGTAB *t, unsigned long long lid, int host)
+{
+    unsigned mask = (unsigned)t->ssCap - 1, k = ssHash(lid, host) & mask;
+    for (;; k = (k + 1) & mask) {
+        SSOPEN *o = &t->ss[k];
+        if (!o->lid || (o->lid == lid && o->host == host)) return o;
+    }
+}
+
+static void ssDrop(LOGTAB *t, SSOPEN *o, bool lost)
+{
+    ACCT *a = &t->acct[o->acct];
+    a->sessOpen--;
+    if (lost) a->sessLost++;
+
+    unsigned mask = (unsigned)t->ssCap - 1, i = (unsigned)(o - t->ss), j = i;
+    for (;;) {                                   /* pull the run back */
+        j = (j + 1) & mask;
+        if (!t->ss[j].lid) break;
+        unsigned k = ssHash(t->ss[j].lid, t->ss[j].host) & mask;
+        if (i <= j ? (i < k && k <= j) : (i < k || k <= j)) continue;
+        t->ss[i] = t->ss[j]; i = j;
+    }
+    t->ss[i].lid = 0;
+    t->ssCnt--;
+}
+
+/* rebuilds the table at ‘cap’ slots, evicting sessions opened
+   before ‘cut’ */
+static void ssRehash(LOGTAB *t, int cap, long long cut)
+{
+    SSOPEN *old = t->ss; int oldCap = t->ssCap;
+    t->ss = (SSOPEN *)xcalloc(cap, sizeof *t->ss);
+    t->ssCap = cap; t->ssCnt = 0;
+    for (int i = 0; i < oldCap; ++i) {
+        const SSOPEN *o = &old[i];
+        if (!o->lid) continue;
+        if (o->t < cut) { t->acct[o->acct].sessOpen--; t->acct[o->acct].sessLost++; continue; }
+        *ssSlot(t, o->lid, o->host) = *o; t->ssCnt++;
+    }
+    free(old);
+}
+
+/* evicts what timed out by the newest event; keeps the load
+   at or under a quarter so the next sweep is far off */
+static void ssSweep(LOGTAB *t)
+{
+    if (!t->ssCap) return;
+    ssRehash(t, t->ssCap, t->ssNow - ssTimeout);
+    int cap = t->ssCap;
+    while (t->ssCnt * 4 > cap) cap *= 2;
+    if (cap != t->ssCap) ssRehash(t, cap, cNoTime);
+    t->ssSwept = t->ssNow;
+}
+
+static void ssFeed(LOGTAB *t, int id, int ai, int host, unsigned long long lid, long long when)
+{
+    if (!lid || ai < 0 || when == cNoTime) return;
+    if (!t->ssCap) {
+        t->ss = (SSOPEN *)xcalloc(1024, sizeof *t->ss);
+        t->ssCap = 1024; t->ssNow = t->ssSwept = when;
+    }
+    if (when > t->ssNow) t->ssNow = when;
+    if (t->ssNow - t->ssSwept >= ssTimeout || (t->ssCnt + 1) * 2 > t->ssCap) ssSweep(t);
+
+    SSOPEN *o = ssSlot(t, lid, host);
+    if (id == 4624) {                            /* logon */
+        if (o->lid) { ssDrop(t, o, true); o = ssSlot(t, lid, host); }
+        *o = (SSOPEN){ lid, when, host, ai };
+        t->ssCnt++;
+        t->acct[ai].sessOpen++;
+        return;
+    }
+    if (!o->lid) return;                         /* logon not seen, or closed */
+    long long d = when - o->t;
+    if (d > ssTimeout) { ssDrop(t, o, true); return; }
+    ACCT *a = &t->acct[o->acct];
+    if (d < 0) d = 0;
+    a->sess++; a->sessSec += d;
+    if (d > a->sessMax) a->sessMax = d;
+    ssDrop(t, o, false);
+}
+
+static void runDetectors(LOGTAB *t)
+{
+    if (t->aggOnly) { ssSweep(t); return; }      /* fed inline instead */
+    t->bfCnt = t->spCnt = 0;
+    for (int i = 0; i < t->spwCap; ++i) t->spw[i] = NULL;
+    for (int i = 0; i < t->aCnt; ++i) {
+        ACCT *a = &t->acct[i];
+        a->bf = NULL;
+        a->sess = a->sessOpen = a->sessLost = 0;
+        a->sessSec = a->sessMax = 0;
+    }
+    free(t->ss); t->ss = NULL; t->ssCnt = t->ssCap = 0;
+
+    buildTimeIndex(t);
+    const EVCOLS *c = &t->ev;
+    for (int k = 0; k < t->tIdxCnt; ++k) {
+        int i = t->tIdx[k];
+        if (c->lid[i]) ssFeed(t, c->id[i], c->acct[i], c->host[i], c->lid[i], c->t[i]);
+        if (!(c->kind[i] & evFail)) continue;
+        bfFeed(t, c->acct[i], c->t[i]);
+        if (c->ws[i] >= 0) spFeed(t, c->ws[i], c->acct[i], c->t[i]);
+        if (c->ip[i] >= 0) spFeed(t, c->ip[i], c->acct[i], c->t[i]);
+    }
+    ssSweep(t);
+}
+
+/* -- 14.  binary snapshot (.cyvalog) ------------------------ */
+/* -----------------------------------------------------------
+   A parsed dataset saved as one file so it can be reopened
+   without touching the CSV again.  Layout: SNHDR, then
+   8-byte aligned sections located by the header's off[] and
+   len[].  Events are stored column by column, their messages
+   as template ids and parameter offsets.  Strings (names,
+   reasons, sources, top-K keys) are interned once; every
+   other section refers to them by id.  Each account's
+   lock-out and reason sets are the next nLock / nRsn entries
+   of their columns.  Numbers use host byte order, so a
+   snapshot only moves between machines of the same
+   endianness.
+
+   Event columns and the parameter heap are stored as they are
+   kept in memory; template literals go through the string
+   table.  Loading copies them back out of the mapped file and
+   rebuilds the small aggregate tables.
+   Retained datasets re-run the detectors under the current
+   thresholds, while aggregate-only ones keep their saved alerts
+   and logon sessions (totals and the open-session table).
+   A snapshot written by follow mode also carries an SNFOLLOW
+   record: how far into the CSV it got.  Files are written
+   to “path.tmp” and renamed over ‘path’, so a crash never
+   leaves half a checkpoint and a mapped snapshot can be
+   replaced while in use.
+   ----------------------------------------------------------- */
+#define cSnapVersion 7
+
+enum {
+    snStr, snStrOff,
+    snTmpl, snTmplTok, snPar,
+    snEvId, snEvT, snEvAcct, snEvKind, snEvWs, snEvIp, snEvHost,
+    snEvTmpl, snEvPar, snEvLen, snEvLid,
+    snTIdx,
+    snAcct, snLockT, snLockC, snRsn, snRsnC, snSess, snSsOpen,
+    snSrc, snSrcC, snHost, snHostC, snNet,
+    snTop, snTopC,
+    snBf, snSp,
+    snFollow,
+    snCount
+};
+
+typedef struct {
+    char          magic[8];                     /* "CYVALOG" */
+    unsigned      version, aggOnly;
+    long long     off[snCount], len[snCount];   /* bytes */
+} SNHDR;
+
+typedef struct { int name, succ, fail, locks, ws, nLock, nRsn, pad; } SNACCT;
+typedef struct { int cap, n; long long total; }                      SNTOP;
+typedef struct { int key, cnt, err, pad; }                           SNTOPC;
+typedef struct { int who, cnt; long long t; }                        SNALERT;
+typedef struct { int id, nTok, old, pad; }                           SNTMPL;
+typedef struct { int n, open, lost, pad; long long sec, max; }       SNSESS;
+typedef struct { IPKEY key; int fam, fails; }                        SNNET;
+
+/* bytes of the CSV consumed, plus a hash of its first headLen
+   bytes to notice when the file was replaced or rotated */
+typedef struct SNFOLLOW { long long offset; unsigned head, headLen; } SNFOLLOW;
+
+#if defined(_MSC_VER)
+#   define FTELL64  _ftelli64
+#   define FSEEK64  _fseeki64
+#else
+#   define FTELL64  ftello
+#   define FSEEK64  fseeko
+#endif
+
+typedef struct { FILE *fp; SNHDR h; ARENA ar; SSET str; } SNOUT;
+
+static void snBegin(SNOUT *o, int sec)
+{
+    static const char zero[8] = {0};
+    long long at = (long long)FTELL64(o->fp);
+    fwrite(zero, 1, (size_t)((8 - at % 8) % 8), o->fp);
+    o->h.off[sec] = (long long)FTELL64(o->fp);
+}
+static void snEnd(SNOUT *o, int sec)
+{ o->h.len[sec] = (long long)FTELL64(o->fp) - o->h.off[sec]; }
+
+#define SNPUT(o, v)  fwrite(&(v), sizeof (v), 1, (o)->fp)
+
+/* one event column, written as held in memory */
+#define SNCOLUMN(o, t, sec, col)                                   \
+    do { snBegin(o, sec);                                          \
+         if ((t)->ev.n)                                            \
+             fwrite((t)->ev.col, sizeof *(t)->ev.col, (t)->ev.n, (o)->fp); \
+         snEnd(o, sec); } while (0)
+
+static int snId(SNOUT *o, const char *s) { return setAdd(&o->ar, &o->str, s, 0); }
+
+static bool saveSnapshot(const LOGTAB *t, const char *path, const SNFOLLOW *fol)
+{
+    SNOUT o = {0};
+    char  tmp[280];
+    cyvaStrcpy(tmp, path); cyvaStrcat(tmp, ".tmp");
+    if (!(o.fp = fopen(tmp, "wb"))) { perror(tmp); return false; }
+    setvbuf(o.fp, NULL, _IOFBF, 1 << 20);
+    cyvaStrcpy(o.h.magic, "CYVALOG");
+    o.h.version = cSnapVersion; o.h.aggOnly = t->aggOnly;
+    SNPUT(&o, o.h);                              /* patched at the end */
+
+    /* events ------------------------------------------------- */
+    snBegin(&o, snTmpl);
+    for (int i = 0; i < t->msg.n; ++i) {
+        const TMPL *tp = &t->msg.tp[i];
+        SNTMPL r = { tp->id, tp->nTok, tp->old, 0 };
+        SNPUT(&o, r);
+    }
+    snEnd(&o, snTmpl);
+    snBegin(&o, snTmplTok);
+    for (int i = 0; i < t->msg.n; ++i)
+        for (int k = 0; k < t->msg.tp[i].nTok; ++k) {
+            int id = t->msg.tp[i].tok[k] ? snId(&o, t->msg.tp[i].tok[k]) : -1;
+            SNPUT(&o, id);
+        }
+    snEnd(&o, snTmplTok);
+    snBegin(&o, snPar);
+    if (t->msg.parLen) fwrite(t->msg.par, 1, (size_t)t->msg.parLen, o.fp);
+    snEnd(&o, snPar);
+
+    SNCOLUMN(&o, t, snEvId,   id);
+    SNCOLUMN(&o, t, snEvT,    t);
+    SNCOLUMN(&o, t, snEvAcct, acct);
+    SNCOLUMN(&o, t, snEvKind, kind);
+    SNCOLUMN(&o, t, snEvWs,   ws);
+    SNCOLUMN(&o, t, snEvIp,   ip);
+    SNCOLUMN(&o, t, snEvHost, host);
+    SNCOLUMN(&o, t, snEvTmpl, tmpl);
+    SNCOLUMN(&o, t, snEvPar,  par);
+    SNCOLUMN(&o, t, snEvLen,  msgLen);
+    SNCOLUMN(&o, t, snEvLid,  lid);
+
+    snBegin(&o, snTIdx);
+    if (t->tIdx && t->tIdxCnt == t->ev.n) fwrite(t->tIdx, sizeof *t->tIdx, t->ev.n, o.fp);
+    snEnd(&o, snTIdx);
+
+    /* accounts ----------------------------------------------- */
+    snBegin(&o, snAcct);
+    for (int i = 0; i < t->aCnt; ++i) {
+        const ACCT *a = &t->acct[i];
+        SNACCT r = { snId(&o, a->name), a->succ, a->fail, a->locks,
+                     a->workstation ? snId(&o, a->workstation) : -1,
+                     a->lockTS.n, a->failRS.n, 0 };
+        SNPUT(&o, r);
+    }
+    snEnd(&o, snAcct);
+
+    snBegin(&o, snLockT);
+    for (int i = 0; i < t->aCnt; ++i)
+        if (t->acct[i].lockTS.n) fwrite(t->acct[i].lockTS.v,   sizeof(long long), t->acct[i].lockTS.n, o.fp);
+    snEnd(&o, snLockT);
+    snBegin(&o, snLockC);
+    for (int i = 0; i < t->aCnt; ++i)
+        if (t->acct[i].lockTS.n) fwrite(t->acct[i].lockTS.cnt, sizeof(int), t->acct[i].lockTS.n, o.fp);
+    snEnd(&o, snLockC);
+    snBegin(&o, snRsn);
+    for (int i = 0; i < t->aCnt; ++i)
+        for (int k = 0; k < t->acct[i].failRS.n; ++k) { int id = snId(&o, t->acct[i].failRS.v[k]); SNPUT(&o, id); }
+    snEnd(&o, snRsn);
+    snBegin(&o, snRsnC);
+    for (int i = 0; i < t->aCnt; ++i)
+        if (t->acct[i].failRS.n) fwrite(t->acct[i].failRS.cnt, sizeof(int), t->acct[i].failRS.n, o.fp);
+    snEnd(&o, snRsnC);
+    snBegin(&o, snSess);
+    for (int i = 0; i < t->aCnt; ++i) {
+        const ACCT *a = &t->acct[i];
+        SNSESS r = { a->sess, a->sessOpen, a->sessLost, 0, a->sessSec, a->sessMax };
+        SNPUT(&o, r);
+    }
+    snEnd(&o, snSess);
+    snBegin(&o, snSsOpen);
+    for (int i = 0; i < t->ssCap; ++i) if (t->ss[i].lid) SNPUT(&o, t->ss[i]);
+    snEnd(&o, snSsOpen);
+
+    /* sources, heavy hitters, alerts ---------------------------- */
+    snBegin(&o, snSrc);
+    for (int i = 0; i < t->src.n; ++i) { int id = snId(&o, t->src.v[i]); SNPUT(&o, id); }
+    snEnd(&o, snSrc);
+    snBegin(&o, snSrcC);
+    if (t->src.n) fwrite(t->src.cnt, sizeof(int), t->src.n, o.fp);
+    snEnd(&o, snSrcC);
+    snBegin(&o, snHost);
+    for (int i = 0; i < t->host.n; ++i) { int id = snId(&o, t->host.v[i]); SNPUT(&o, id); }
+    snEnd(&o, snHost);
+    snBegin(&o, snHostC);
+    if (t->host.n) fwrite(t->host.cnt, sizeof(int), t->host.n, o.fp);
+    snEnd(&o, snHostC);
+    snBegin(&o, snNet);
+    for (int i = 1; i < t->net.cnt; ++i) {      /* leaves only */
+        const IPNODE *x = &t->net.n[i];
+        SNNET r = { x->key, x->bits == 128, x->fails };
+        if (!x->kid[0]) SNPUT(&o, r);
+    }
+    snEnd(&o, snNet);
+
+    snBegin(&o, snTop);
+    for (int k = 0; k < tkCount; ++k) {
+        SNTOP r = { t->top[k].cap, t->top[k].n, t->top[k].total };
+        SNPUT(&o, r);
+    }
+    snEnd(&o, snTop);
+    snBegin(&o, snTopC);
+    for (int k = 0; k < tkCount; ++k)
+        for (int i = 0; i < t->top[k].n; ++i) {
+            const TOPC *c = &t->top[k].c[i];
+            SNTOPC r = { snId(&o, c->key), c->cnt, c->err, 0 };
+            SNPUT(&o, r);
+        }
+    snEnd(&o, snTopC);
+
+    snBegin(&o, snBf);
+    for (int i = 0; i < t->bfCnt; ++i) {
+        SNALERT r = { t->bfAl[i].acct, t->bfAl[i].cnt, t->bfAl[i].t };
+        SNPUT(&o, r);
+    }
+    snEnd(&o, snBf);
+    snBegin(&o, snSp);
+    for (int i = 0; i < t->spCnt; ++i) {
+        SNALERT r = { t->spAl[i].src, t->spAl[i].est, t->spAl[i].t };
+        SNPUT(&o, r);
+    }
+    snEnd(&o, snSp);
+
+    snBegin(&o, snFollow);
+    if (fol) SNPUT(&o, *fol);
+    snEnd(&o, snFollow);
+
+    /* string table last: every id is known by now ---------------- */
+    snBegin(&o, snStr);
+    long long so = 0;
+    for (int i = 0; i < o.str.n; ++i) fwrite(o.str.v[i], 1, LEN(o.str.v[i]) + 1, o.fp);
+    snEnd(&o, snStr);
+    snBegin(&o, snStrOff);
+    for (int i = 0; i < o.str.n; ++i) { SNPUT(&o, so); so += (long long)LEN(o.str.v[i]) + 1; }
+    snEnd(&o, snStrOff);
+
+    bool ok = !ferror(o.fp) && !FSEEK64(o.fp, 0, SEEK_SET) && SNPUT(&o, o.h) == 1;
+    ok = !fclose(o.fp) && ok;
+    arenaFree(&o.ar);
+#if defined(_MSC_VER)
+    ok = ok && MoveFileExA(tmp, path, MOVEFILE_REPLACE_EXISTING);
+#else
+    ok = ok && !rename(tmp, path);
+#endif
+    if (!ok) { perror(path); remove(tmp); }
+    return ok;
+}
+
+static bool isSnapshot(const char *path)
+{
+    char  magic[8] = {0};
+    FILE *fp = fopen(path, "rb");
+    if (!fp) return false;
+    bool ok = fread(magic, 1, sizeof magic, fp) == sizeof magic &&
+              !NCMP(magic, "CYVALOG", sizeof magic);
+    fclose(fp);
+    return ok;
+}
+
+/* section ‘sec’ as an array of ‘ty’, element count in *n */
+#define SNSEC(ty, sec, n)  ((n) = (int)(h.len[sec] / (long long)sizeof(ty)), \
+                            (const ty *)(m.p + h.off[sec]))
+
+/* -----------------------------------------------------------
+   loadSnapshot  –  into the (empty) dataset ‘lg’.  Every
+   section, string id and slice is bounds-checked against the
+   file before use, so a truncated or foreign file is rejected
+   rather than trusted.  *fol (if given) receives the follow
+   record, zeroed when the snapshot has none.
+   ----------------------------------------------------------- */
+static bool loadSnapshot(const char *path, SNFOLLOW *fol)
+{
+    parserInit();                                /* reports re-read messages */
+    LOGMAP m; SNHDR h;
+    if (!mapFile(path, &m)) return false;
+    bool ok = m.n >= sizeof h;
+    if (ok) { cyvaMemcpy(&h, m.p, sizeof h);
+              ok = !NCMP(h.magic, "CYVALOG", sizeof h.magic) && h.version == cSnapVersion; }
+    for (int s = 0; ok && s < snCount; ++s)
+        ok = h.off[s] >= (long long)sizeof h && h.off[s] % 8 == 0 && h.len[s] >= 0 &&
+             h.len[s] <= (long long)m.n - h.off[s];
+    if (!ok) { fprintf(stderr, "%s: not a version %d snapshot\n", path, cSnapVersion);
+               unmapFile(&m); return false; }
+
+    int nStr, nOff, nEv, n, nA, nTp, nTk, nLT, nLC, nR, nRC, nS, nSC, nH, nHC, nT, nTC, nB, nSp, nTI,
+        nSs, nSo, nN;
+    const char      *str  = SNSEC(char,          snStr,    nStr);
+    const long long *sOff = SNSEC(long long,     snStrOff, nOff);
+    const SNTMPL    *tpl  = SNSEC(SNTMPL,        snTmpl,   nTp);
+    const int       *tk   = SNSEC(int,           snTmplTok, nTk);
+    const char      *par  = m.p + h.off[snPar];
+    const unsigned short *id = SNSEC(unsigned short, snEvId, nEv);
+    const long long *et   = SNSEC(long long,     snEvT,    n); ok = n == nEv;
+    const int       *ea   = SNSEC(int,           snEvAcct, n); ok = ok && n == nEv;
+    const unsigned char *ek = SNSEC(unsigned char, snEvKind, n); ok = ok && n == nEv;
+    const int       *ew   = SNSEC(int,           snEvWs,   n); ok = ok && n == nEv;
+    const int       *ei   = SNSEC(int,           snEvIp,   n); ok = ok && n == nEv;
+    const int       *eh   = SNSEC(int,           snEvHost, n); ok = ok && n == nEv;
+    const int       *eT   = SNSEC(int,           snEvTmpl, n); ok = ok && n == nEv;
+    const long long *eo   = SNSEC(long long,     snEvPar,  n); ok = ok && n == nEv;
+    const unsigned  *el   = SNSEC(unsigned,      snEvLen,  n); ok = ok && n == nEv;
+    const unsigned long long *eL = SNSEC(unsigned long long, snEvLid, n); ok = ok && n == nEv;
+    const int       *ti   = SNSEC(int,           snTIdx,   nTI);
+    const SNACCT    *ac   = SNSEC(SNACCT,        snAcct,   nA);
+    const long long *lt   = SNSEC(long long,     snLockT,  nLT);
+    const int       *lc   = SNSEC(int,           snLockC,  nLC);
+    const int       *rs   = SNSEC(int,           snRsn,    nR);
+    const int       *rc   = SNSEC(int,           snRsnC,   nRC);
+    const SNSESS    *ss   = SNSEC(SNSESS,        snSess,   nSs);
+    const SSOPEN    *so   = SNSEC(SSOPEN,        snSsOpen, nSo);
+    const int       *sr   = SNSEC(int,           snSrc,    nS);
+    const int       *sc   = SNSEC(int,           snSrcC,   nSC);
+    const int       *hs   = SNSEC(int,           snHost,   nH);
+    const int       *hc   = SNSEC(int,           snHostC,  nHC);
+    const SNNET     *net  = SNSEC(SNNET,         snNet,    nN);
+    const SNTOP     *tp   = SNSEC(SNTOP,         snTop,    nT);
+    const SNTOPC    *tc   = SNSEC(SNTOPC,        snTopC,   nTC);
+    const SNALERT   *bf   = SNSEC(SNALERT,       snBf,     nB);
+    const SNALERT   *sp   = SNSEC(SNALERT,       snSp,     nSp);
+    const SNFOLLOW  *fw   = SNSEC(SNFOLLOW,      snFollow, n);
+    ok = ok && (n == 0 || n == 1);
+    if (fol) *fol = ok && n ? *fw : (SNFOLLOW){0};
+    if (!nOff && nStr) ok = false;
+    ok = ok && nLT == nLC && nR == nRC && nS == nSC && nH == nHC && nT == tkCount && nSs == nA;
+    for (int i = 0; ok && i < nOff; ++i)         /* each string ends in the table */
+    {
+        long long end = i + 1 < nOff ? sOff[i + 1] : nStr;
+        ok = sOff[i] >= 0 && sOff[i] < end && end <= nStr && str[end - 1] == '\0';
+    }
+
+#define SNSTR(i)  ((i) >= 0 && (i) < nOff ? str + sOff[i] : (ok = false, ""))
+
+    LOGTAB *t = &lg;
+    t->aggOnly = h.aggOnly != 0;
+
+    /* aggregates, rebuilt in saved order so ids stay valid ------- */
+    for (int i = 0, li = 0, ri = 0; ok && i < nA; ++i) {
+        const SNACCT *r = &ac[i];
+        if (r->nLock < 0 || r->nRsn < 0 || r->nLock > nLT - li || r->nRsn > nR - ri) { ok = false; break; }
+        ACCT *a = getAcct(t, SNSTR(r->name), true);
+        if (a != &t->acct[i]) { ok = false; break; } /* duplicate name */
+        a->succ = r->succ; a->fail = r->fail; a->locks = r->locks;
+        if (r->ws >= 0) a->workstation = arenaStrdup(&t->ar, SNSTR(r->ws));
+        for (int k = 0; k < r->nLock; ++k, ++li) tsetAdd(&t->ar, &a->lockTS, lt[li], lc[li]);
+        for (int k = 0; k < r->nRsn;  ++k, ++ri) setAdd(&t->ar, &a->failRS, SNSTR(rs[ri]), rc[ri]);
+    }
+    for (int i = 0, ki = 0; ok && i < nTp; ++i) {      /* templates */
+        if (tpl[i].nTok < 0 || tpl[i].nTok > nTk - ki) { ok = false; break; }
+        const char **tok = (const char **)arenaAlloc(&t->ar, tpl[i].nTok * sizeof *tok);
+        unsigned    *len = (unsigned *)   arenaAlloc(&t->ar, tpl[i].nTok * sizeof *len);
+        for (int k = 0; k < tpl[i].nTok; ++k, ++ki) {
+            tok[k] = tk[ki] < 0 ? NULL : arenaStrdup(&t->ar, SNSTR(tk[ki]));
+            len[k] = tok[k] ? (unsigned)LEN(tok[k]) : 0;
+        }
+        tmplPush(&t->msg, tpl[i].id, tpl[i].nTok, tok, len);
+        t->msg.tp[i].old = tpl[i].old != 0;
+    }
+    for (int i = 0; ok && i < nS; ++i)
+        if (setAdd(&t->ar, &t->src, SNSTR(sr[i]), sc[i]) != i) ok = false;
+    for (int i = 0; ok && i < nH; ++i)
+        if (setAdd(&t->ar, &t->host, SNSTR(hs[i]), hc[i]) != i) ok = false;
+    for (int i = 0; ok && i < nN; ++i)
+        if ((ok = (net[i].fam == 0 || net[i].fam == 1) && net[i].fails > 0))
+            ipAdd(&t->net, net[i].fam, &net[i].key, net[i].fails);
+    for (int k = 0, ci = 0; ok && k < tkCount; ++k) {
+        if (tp[k].n < 0 || tp[k].n > nTC - ci || tp[k].n > tp[k].cap ||
+            tp[k].cap > (1 << 24)) { ok = false; break; }
+        if (tp[k].cap) topInit(&t->top[k], tp[k].cap);
+        for (int i = 0; i < tp[k].n; ++i, ++ci) topAdd(&t->top[k], SNSTR(tc[ci].key), tc[ci].cnt, tc[ci].err);
+        t->top[k].total = tp[k].total;
+    }
+
+    /* events: columns and parameter heap copied as they are */
+    if (ok && nEv && !t->aggOnly) {
+        for (int i = 0; ok && i < nEv; ++i)
+            ok = eo[i] >= 0 && eo[i] <= h.len[snPar] && eT[i] >= 0 && eT[i] < nTp &&
+                 ea[i] >= -1 && ea[i] < t->aCnt &&
+                 ew[i] >= -1 && ew[i] < nS && ei[i] >= -1 && ei[i] < nS &&
+                 eh[i] >= -1 && eh[i] < nH;
+        if (ok) {
+            EVCOLS *c = &t->ev;
+            evReserve(c, nEv);
+            MSGSTORE *ms = &t->msg;
+            ms->parCap = ms->parLen = h.len[snPar];
+            ms->par    = (char *)xmalloc((size_t)ms->parLen + 1);
+            cyvaMemcpy(ms->par, par, (size_t)ms->parLen);
+            cyvaMemcpy(c->tmpl,   eT, nEv * sizeof *eT);
+            cyvaMemcpy(c->par,    eo, nEv * sizeof *eo);
+            cyvaMemcpy(c->msgLen, el, nEv * sizeof *el);
+            cyvaMemcpy(c->id,     id, nEv * sizeof *id);
+            cyvaMemcpy(c->t,      et, nEv * sizeof *et);
+            cyvaMemcpy(c->acct,   ea, nEv * sizeof *ea);
+            cyvaMemcpy(c->kind,   ek, nEv * sizeof *ek);
+            cyvaMemcpy(c->ws,     ew, nEv * sizeof *ew);
+            cyvaMemcpy(c->ip,     ei, nEv * sizeof *ei);
+            cyvaMemcpy(c->host,   eh, nEv * sizeof *eh);
+            cyvaMemcpy(c->lid,    eL, nEv * sizeof *eL);
+            c->n = nEv;
+        }
+        if (ok && nTI == nEv) {
+            t->tIdx = (int*)xmalloc((nEv + 1) * sizeof *t->tIdx);
+            for (int i = 0; ok && i < nEv; ++i) ok = ti[i] >= 0 && ti[i] < nEv;
+            if (ok) { cyvaMemcpy(t->tIdx, ti, nEv * sizeof *ti); t->tIdxCnt = nEv; }
+        }
+    }
+
+    if (ok && t->aggOnly) {                      /* alerts as saved */
+        for (int i = 0; ok && i < nB; ++i) ok = bf[i].who >= 0 && bf[i].who < t->aCnt;
+        for (int i = 0; ok && i < nSp; ++i) ok = sp[i].who >= 0 && sp[i].who < nS;
+        if (ok && nB) {
+            t->bfAl = (BFALERT*)xmalloc(nB * sizeof *t->bfAl); t->bfCap = t->bfCnt = nB;
+            for (int i = 0; i < nB; ++i) t->bfAl[i] = (BFALERT){ bf[i].who, bf[i].t, bf[i].cnt };
+        }
+        if (ok && nSp) {
+            t->spAl = (SPALERT*)xmalloc(nSp * sizeof *t->spAl); t->spCap = t->spCnt = nSp;
+            for (int i = 0; i < nSp; ++i) t->spAl[i] = (SPALERT){ sp[i].who, sp[i].t, sp[i].cnt };
+        }
+        for (int i = 0; i < nA; ++i) {
+            ACCT *a = &t->acct[i];
+            a->sess = ss[i].n; a->sessOpen = ss[i].open; a->sessLost = ss[i].lost;
+            a->sessSec = ss[i].sec; a->sessMax = ss[i].max;
+        }
+        for (int i = 0; ok && i < nSo; ++i)
+            ok = so[i].lid && so[i].acct >= 0 && so[i].acct < t->aCnt &&
+                 so[i].host >= -1 && so[i].host < nH;
+        if (ok && nSo) {                         /* open sessions, re-hashed */
+            int cap = 1024;
+            while (nSo * 4 > cap) cap *= 2;
+            t->ss = (SSOPEN *)xcalloc(cap, sizeof *t->ss); t->ssCap = cap;
+            for (int i = 0; ok && i < nSo; ++i) {
+                SSOPEN *o = ssSlot(t, so[i].lid, so[i].host);
+                ok = !o->lid;                    /* duplicate key */
+                *o = so[i]; t->ssCnt++;
+                if (so[i].t > t->ssNow || i == 0) t->ssNow = so[i].t;
+            }
+            t->ssSwept = t->ssNow;
+        }
+    }
+#undef SNSTR
+
+    if (!ok) {
+        fprintf(stderr, "%s: corrupt snapshot\n", path);
+        freeTab(t); unmapFile(&m);
+        return false;
+    }
+    runDetectors(t);                             /* no-op if aggOnly */
+    unmapFile(&m);
+    return true;
+}
+#undef SNSEC
+
+/* -- 15.  follow mode ------------------------------------- */
+/* -----------------------------------------------------------
+   NXLog appends to the day's CSV as events arrive.  Follow
+   mode loads it once up to the last complete row, then polls.
+   Appended bytes are read in cStreamBlock blocks, so a long
+   pause or a large append never needs more memory than one
+   block (plus a row that outgrows it).  Complete rows go
+   through the same parseRows() into ‘lg’ with ‘live’ set, so
+   aggregates and detectors update in place; a partial row is
+   carried into the next block.  A half-written
+   last row is simply not consumed: the offset stops before it
+   and the next poll reads it again.
+
+   The checkpoint is a snapshot next to the CSV (“.cyvalog”)
+   with an SNFOLLOW record.  It is written every cCkptSecs
+   while rows arrive, and on stop.  A restart loads it instead
+   of the CSV and resumes at its offset.  If the CSV is now
+   shorter than that, or its first bytes changed (rotated), it
+   is read from the beginning instead.
+   ----------------------------------------------------------- */
+#define cFollowPollMs 1000
+#define cCkptSecs     60
+#define cFollowHead   4096u                     /* bytes fingerprinted */
+
+typedef struct {
+    char      path[260], ckpt[270];
+    SNFOLLOW  at;
+    time_t    saved;                            /* last checkpoint */
+    bool      dirty;
+} FOLLOW;
+
+static long long fileSize(FILE *fp)
+{ return FSEEK64(fp, 0, SEEK_END) ? -1 : (long long)FTELL64(fp); }
+
+static bool fileHead(FILE *fp, unsigned n, unsigned *h)   /* FNV-1a */
+{
+    unsigned char buf[cFollowHead];
+    if (n > sizeof buf || FSEEK64(fp, 0, SEEK_SET) || fread(buf, 1, n, fp) != n) return false;
+    *h = 2166136261u;
+    for (unsigned i = 0; i < n; ++i) { *h ^= buf[i]; *h *= 16777619u; }
+    return true;
+}
+
+/* same file as at the checkpoint, and not truncated since */
+static bool followValid(const FOLLOW *f, FILE *fp, long long size)
+{
+    unsigned h;
+    return size >= f->at.offset && fileHead(fp, f->at.headLen, &h) && h == f->at.head;
+}
+
+/* the header line's column layout (snapshots do not keep it) */
+static bool fileColumns(FILE *fp, COLMAP *c)
+{
+    char line[8192];
+    if (FSEEK64(fp, 0, SEEK_SET) || !fgets(line, sizeof line, fp)) return false;
+    size_t n = LEN(line);
+    if (!n || line[n - 1] != '\n') return false;
+    while (n && (line[n - 1] == '\n' || line[n - 1] == '\r')) --n;
+    readColumns(c, line, line + n);
+    return true;
+}
+
+static bool followStart(FOLLOW *f, const char *csv)
+{
+    parserInit();                                /* polls parse rows too */
+    char path[260];
+    cyvaStrcpy(path, csv);
+    cyvaStrcpy(f->path, path);
+    cyvaStrcpy(f->ckpt, path); cyvaStrcat(f->ckpt, ".cyvalog");
+    f->saved = time(NULL); f->dirty = false;
+    closeDataset();
+
+    FILE *fp = fopen(path, "rb");
+    if (!fp) { perror(path); return false; }
+    long long size = fileSize(fp);
+
+    if (isSnapshot(f->ckpt) && loadSnapshot(f->ckpt, &f->at) && !lg.aggOnly &&
+        f->at.headLen && followValid(f, fp, size) && fileColumns(fp, &lg.col))
+        printf("Resumed from %s at byte %lld.\n", f->ckpt, f->at.offset);
+    else {
+        closeDataset();
+        f->at = (SNFOLLOW){0};
+        if (!loadCSVUpTo(path, &f->at.offset)) { fclose(fp); return false; }
+        f->at.headLen = f->at.offset < cFollowHead ? (unsigned)f->at.offset : cFollowHead;
+        fileHead(fp, f->at.headLen, &f->at.head);
+        f->dirty = true;
+    }
+    fclose(fp);
+    lg.live = true;
+    return true;
+}
+
+/* one poll: new events parsed, or -1 if the file was replaced */
+static int followPoll(FOLLOW *f)
+{
+    FILE *fp = fopen(f->path, "rb");
+    if (!fp) return 0;                           /* mid-rotation: retry */
+    long long size = fileSize(fp);
+    if (!followValid(f, fp, size)) { fclose(fp); return -1; }
+
+    int before = lg.ev.n;
+    if (size > f->at.offset && !FSEEK64(fp, f->at.offset, SEEK_SET)) {
+        long long left = size - f->at.offset;    /* bytes not read yet */
+        size_t cap = cStreamBlock, have = 0;     /* have: carried row  */
+        char  *buf = (char *)xmalloc(cap);
+        while (left > 0) {
+            if (have == cap) {                   /* one row outgrew the block */
+                buf = (char *)realloc(buf, cap *= 2);
+                if (!buf) { perror("OOM"); exit(1); }
+            }
+            size_t want = cap - have;
+            if ((long long)want > left) want = (size_t)left;
+            size_t got = fread(buf + have, 1, want, fp);
+            if (!got) break;
+            left -= (long long)got;
+            size_t len = have + got, used = parseRows(&lg, buf, len, false);
+            if (used) { f->at.offset += (long long)used; f->dirty = true; }
+            have = len - used;
+            for (size_t i = 0; used && i < have; ++i) buf[i] = buf[used + i];
+        }
+        free(buf);
+        if (lg.ev.n > before) ssSweep(&lg);     /* time out stale sessions */
+    }
+    fclose(fp);
+    return lg.ev.n - before;
+}
+
+static void followSave(FOLLOW *f)
+{
+    if (!f->dirty) return;
+    if (saveSnapshot(&lg, f->ckpt, &f->at)) f->dirty = false;
+    f->saved = time(NULL);
+}
+
+/* -- 16.  Reporting helpers ------------------------------- */
+static void listAccountsAll(void)
+{
+    printf("\nAccounts (%d):\n", lg.aCnt);
+    for (int i = 0; i < lg.aCnt; ++i) printf("  %s\n", lg.acct[i].name);
+    puts("");
+}
+static void listAccountsLocked(void)
+{
+    int n = 0; puts("\nLocked-out accounts:");
+    for (int i = 0; i < lg.aCnt; ++i) if (lg.acct[i].locks) {
+        printf("  %s\n", lg.acct[i].name); ++n;
+    }
+    if (!n) puts("  (none)");
+    puts("");
+}
+static const char *fmtCount(int n, char *buf)    /* 3412 -> "3,412" */
+{
+    char tmp[16]; int i = 0, o = 0;
+    do { tmp[i++] = (char)('0' + n % 10); n /= 10; } while (n);
+    while (i) { buf[o++] = tmp[--i]; if (i && i % 3 == 0) buf[o++] = ','; }
+    buf[o] = '\0';
+    return buf;
+}
+static const char *fmtDur(long long sec, char *buf, size_t cap)  /* "2d 03:04:05" */
+{
+    long long d = sec / 86400; sec %= 86400;
+    if (d) snprintf(buf, cap, "%lldd %02d:%02d:%02d", d, (int)(sec / 3600),
+                    (int)(sec / 60 % 60), (int)(sec % 60));
+    else   snprintf(buf, cap, "%02d:%02d:%02d", (int)(sec / 3600),
+                    (int)(sec / 60 % 60), (int)(sec % 60));
+    return buf;
+}
+static void printSet(const SSET *s)
+{
+    if (s->n == 0) { puts("  (none)"); return; }
+    char num[24];
+    for (int i = 0; i < s->n; ++i)
+        if (s->cnt[i] > 1) printf("  - %s x%s\n", s->v[i], fmtCount(s->cnt[i], num));
+        else               printf("  - %s\n", s->v[i]);
+}
+static void printTSet(const TSET *s)
+{
+    if (s->n == 0) { puts("  (none)"); return; }
+    char num[24], when[32];
+    for (int i = 0; i < s->n; ++i) {
+        fmtTime(s->v[i], when, sizeof when);
+        if (s->cnt[i] > 1) printf("  - %s x%s\n", when, fmtCount(s->cnt[i], num));
+        else               printf("  - %s\n", when);
+    }
+}
+static void printAcct(const ACCT *a)
+{
+    printf("\n===== %s =====\n", a->name);
+    printf("Successful logons : %d\n", a->succ);
+    printf("Failed logons     : %d\n", a->fail);
+    printf("Lock-out events   : %d\n", a->locks);
+    printf("Workstation       : %s\n",
+           a->workstation ? a->workstation : "(none)");
+    if (a->sess || a->sessOpen || a->sessLost) {
+        char tot[32], mx[32];
+        printf("Logon sessions    : %d closed, %d open, %d timed out\n",
+               a->sess, a->sessOpen, a->sessLost);
+        printf("Session time      : %s total, %s longest\n",
+               fmtDur(a->sessSec, tot, sizeof tot), fmtDur(a->sessMax, mx, sizeof mx));
+    }
+
+    puts("\nFailure reasons:");
+    printSet(&a->failRS);
+
+    puts("\nLock-out timestamps:");
+    printTSet(&a->lockTS);
+}
+static void showAccount(const char *name)
+{
+    ACCT *a = getAcct(&lg, name, false);
+    if (!a) { printf("  \"%s\" not found.\n\n", name); return; }
+    printAcct(a);
+}
+
+/* -----------------------------------------------------------
+   Time-bounded variants.  Counters come from the kind column; the
+   reasons and workstation are re-read from the messages of
+   the events in range only, into a scratch ACCT.
+   ----------------------------------------------------------- */
+static void showAccountRange(const char *name, long long t0, long long t1)
+{
+    ACCT *a = getAcct(&lg, name, false);
+    if (!a) { printf("  \"%s\" not found.\n\n", name); return; }
+
+    int from, to;
+    if (!timeRange(&lg, t0, t1, &from, &to)) return;
+
+    int   ai = (int)(a - lg.acct);
+    ARENA tmp = {0};
+    ACCT  w   = {0};
+    char *text = NULL; size_t textCap = 0;
+    w.name = a->name;
+
+    const EVCOLS *c = &lg.ev;
+    for (int k = from; k < to; ++k) {
+        int i = lg.tIdx[k];
+        if (c->acct[i] != ai || !c->kind[i]) continue;
+
+        MSGF mf;
+        if (c->kind[i] & (evFail | evLock)) {
+            if (c->msgLen[i] > textCap) { textCap = c->msgLen[i];
+                                          text = (char *)realloc(text, textCap); }
+            msgTokenize(text, msgText(&lg.msg, c->tmpl[i], c->par[i], text, textCap), &mf);
+        }
+        if (c->kind[i] & evSucc) w.succ++;
+        if (c->kind[i] & evFail) {
+            char rsn[256];
+            w.fail++;
+            if (failReason(&mf, rsn, sizeof rsn)) setAdd(&tmp, &w.failRS, rsn, 1);
+        }
+        if (c->kind[i] & evLock) {
+            w.locks++;
+            tsetAdd(&tmp, &w.lockTS, c->t[i], 1);
+            char ws[128];
+            if (!w.workstation && workstationFromMsg(&mf, ws, sizeof ws))
+                w.workstation = arenaStrdup(&tmp, ws);
+        }
+    }
+    printAcct(&w);
+    arenaFree(&tmp);
+    free(text);
+}
+
+static void listAccountsLockedRange(long long t0, long long t1)
+{
+    int from, to;
+    if (!timeRange(&lg, t0, t1, &from, &to)) return;
+
+    int *hits = (int*)xcalloc(lg.aCnt + 1, sizeof *hits), n = 0;
+    for (int k = from; k < to; ++k) {
+        int i = lg.tIdx[k];
+        if ((lg.ev.kind[i] & evLock) && lg.ev.acct[i] >= 0) hits[lg.ev.acct[i]]++;
+    }
+
+    char num[24];
+    puts("\nLocked-out accounts in range:");
+    for (int i = 0; i < lg.aCnt; ++i) if (hits[i]) {
+        printf("  %s (%s)\n", lg.acct[i].name, fmtCount(hits[i], num)); ++n;
+    }
+    if (!n) puts("  (none)");
+    puts("");
+    free(hits);
+}
+
+/* -- 17.  Event queries ----------------------------------- */
+/* -----------------------------------------------------------
+   A small filter language over the event columns, e.g.
+     id in (4625,4771) && account ~ "svc_*" && time >= 2026-10-01T00:00
+   Fields: id, time, account, host, source (workstation or
+   address) and kind (success, failure, lockout).  Operators:
+   == != < <= > >= on id and time, in (…) on all but time
+   (names in the list may be globs), ~ and !~ (glob with * and
+   ?) on names, && || ! and parentheses.  Names compare
+   without case; times are local, as at the other prompts.
+
+   qCompile() parses the text once into a plan whose leaves
+   have one of two shapes: an inclusive [lo, hi] on the id or
+   time column, or a byte map indexed by the column value.
+   Name fields are matched against their dictionary (accounts,
+   sources, hosts) once at compile time, so rows are never
+   compared as strings.  The terms of an && are ordered by the
+   share of a row sample they pass, narrowest first; those of
+   an || widest first.  qEval() works column at a time on a
+   selection vector of row numbers: a leaf is one branch-free
+   loop over the rows still alive, && narrows the vector in
+   place, || and ! merge sorted sub-selections.
+   ----------------------------------------------------------- */
+#define cQSample 4096                   /* rows to rank terms on */
+#define cQMaxKids 64
+
+enum { qfId, qfTime, qfAcct, qfHost, qfSrc, qfKind };
+enum { qAnd, qOr, qNot, qRange, qMap };
+
+typedef struct QNODE {
+    int            op, field;
+    long long      lo, hi;              /* qRange                  */
+    unsigned char *map;                 /* qMap: id/kind by value,
+                                           names by index + 1      */
+    struct QNODE **kid;  int nKid;
+    double         pass;                /* sampled share passing   */
+} QNODE;
+
+typedef struct {
+    const char *s, *p;                  /* text, cursor            */
+    ARENA      *ar;
+    char        err[96];
+} QPARSE;
+
+static bool globMatch(const char *p, const char *s)   /* * ?, no case */
+{
+    const char *star = NULL, *back = NULL;
+    while (*s) {
+        if (*p == '*') { star = p++; back = s; continue; }
+        if (*p == '?' || (*p && tolower((unsigned char)*p) == tolower((unsigned char)*s))) {
+            ++p; ++s; continue;
+        }
+        if (!star) return false;
+        p = star + 1; s = ++back;
+    }
+    while (*p == '*') ++p;
+    return !*p;
+}
+
+static bool qSame(const char *a, const char *b) { return nameIs(a, LEN(a), b); }
+
+static void qSkip(QPARSE *q) { while (isspace((unsigned char)*q->p)) ++q->p; }
+
+static bool qEat(QPARSE *q, const char *tok)
+{
+    qSkip(q);
+    size_t n = LEN(tok);
+    if (NCMP(q->p, tok, n)) return false;
+    q->p += n;
+    return true;
+}
+
+static bool qFail(QPARSE *q, const char *what)
+{
+    if (!*q->err)
+        snprintf(q->err, sizeof q->err, "%s at column %d", what, (int)(q->p - q->s) + 1);
+    return false;
+}
+
+/* a quoted string or bare word into out[cap] */
+static bool qWord(QPARSE *q, char *out, size_t cap)
+{
+    qSkip(q);
+    size_t n = 0;
+    if (*q->p == '"') {
+        for (++q->p; *q->p && *q->p != '"'; ++q->p) if (n + 1 < cap) out[n++] = *q->p;
+        if (*q->p != '"') return qFail(q, "Unclosed quote");
+        ++q->p;
+    } else {
+        for (; *q->p && !isspace((unsigned char)*q->p) && !cyvaStrchr("()!,&|=<>~\"", *q->p); ++q->p)
+            if (n + 1 < cap) out[n++] = *q->p;
+        if (!n) return qFail(q, "Expected a value");
+    }
+    out[n] = '\0';
+    return true;
+}
+
+static QNODE *qNew(QPARSE *q, int op, int field)
+{
+    QNODE *n = (QNODE *)arenaCalloc(q->ar, sizeof *n);
+    n->op = op; n->field = field;
+    return n;
+}
+
+static QNODE *qWrap(QPARSE *q, int op, QNODE *kid)
+{
+    QNODE *n = qNew(q, op, 0);
+    n->kid = (QNODE **)arenaAlloc(q->ar, sizeof *n->kid);
+    n->kid[0] = kid; n->nKid = 1;
+    return n;
+}
+
+/* dictionary behind a name field */
+static const SSET *qDict(int field) { return field == qfHost ? &lg.host : &lg.src; }
+
+/* sets map entries for one value of the field; false if unknown */
+static bool qMark(QPARSE *q, QNODE *n, const char *v, bool glob)
+{
+    switch (n->field) {
+    case qfId: {
+        char *end; long id = cyvaStrtol(v, &end, 10);
+        if (*end || id < 0 || id > 0xFFFF) return qFail(q, "Bad event id");
+        n->map[id] = 1;
+        return true;
+    }
+    case qfKind: {
+        int bit = qSame(v, "success") ? evSucc : qSame(v, "failure") ? evFail :
+                  qSame(v, "lockout") ? evLock : 0;
+        if (!bit) return qFail(q, "Kind is success, failure or lockout");
+        for (int k = 0; k < 256; ++k) if (k & bit) n->map[k] = 1;
+        return true;
+    }
+    case qfAcct:
+        for (int i = 0; i < lg.aCnt; ++i)
+            if (glob ? globMatch(v, lg.acct[i].name) : qSame(v, lg.acct[i].name))
+                n->map[i + 1] = 1;
+        return true;
+    default: {
+        const SSET *d = qDict(n->field);
+        for (int i = 0; i < d->n; ++i)
+            if (glob ? globMatch(v, d->v[i]) : qSame(v, d->v[i])) n->map[i + 1] = 1;
+        return true;
+    }
+    }
+}
+
+static QNODE *qExpr(QPARSE *q);
+
+static QNODE *qPred(QPARSE *q)
+{
+    static const struct { const char *name; int field; } kField[] = {
+        { "id", qfId }, { "time", qfTime }, { "account", qfAcct },
+        { "host", qfHost }, { "source", qfSrc }, { "kind", qfKind },
+    };
+    char name[32], v[256];
+    if (!qWord(q, name, sizeof name)) return NULL;
+    int field = -1;
+    for (size_t i = 0; i < sizeof kField / sizeof *kField; ++i)
+        if (qSame(name, kField[i].name)) field = kField[i].field;
+    if (field < 0) { qFail(q, "Unknown field"); return NULL; }
+
+    static const char *const kOp[] = { "==", "!=", "<=", ">=", "!~", "<", ">", "=", "~", "in" };
+    int op = -1;
+    for (int i = 0; i < 10 && op < 0; ++i) if (qEat(q, kOp[i])) op = i;
+    if (op < 0) { qFail(q, "Expected an operator"); return NULL; }
+    const char *o = kOp[op];
+    bool neg = !CMP(o, "!=") || !CMP(o, "!~");
+
+    bool glob = cyvaStrchr(o, '~') != NULL, in = !CMP(o, "in");
+    bool ranged = field == qfTime || (field == qfId && !in && !glob);
+    if (field == qfTime && (in || glob)) { qFail(q, "Time takes == != < <= > >="); return NULL; }
+    if ((field == qfId || field == qfKind) && glob) { qFail(q, "Globs apply to names only"); return NULL; }
+    if (!ranged && (o[0] == '<' || o[0] == '>')) { qFail(q, "Names take == != ~ !~ in"); return NULL; }
+
+    if (ranged) {
+        long long x;
+        if (!qWord(q, v, sizeof v)) return NULL;
+        if (field == qfTime) {
+            if (!parseLocal(v, &x)) { qFail(q, "Bad time"); return NULL; }
+        } else {
+            char *end; x = cyvaStrtol(v, &end, 10);
+            if (*end || x < 0 || x > 0xFFFF) { qFail(q, "Bad event id"); return NULL; }
+        }
+        QNODE *n = qNew(q, qRange, field);
+        n->lo = cNoTime; n->hi = 0x7FFFFFFFFFFFFFFFLL;
+        if      (!CMP(o, "<"))  n->hi = x - 1;
+        else if (!CMP(o, "<=")) n->hi = x;
+        else if (!CMP(o, ">"))  n->lo = x + 1;
+        else if (!CMP(o, ">=")) n->lo = x;
+        else                    n->lo = n->hi = x;
+        return neg ? qWrap(q, qNot, n) : n;
+    }
+
+    QNODE *n = qNew(q, qMap, field);
+    size_t mapN = field == qfId ? 0x10000 : field == qfKind ? 256 :
+                  (size_t)(field == qfAcct ? lg.aCnt : qDict(field)->n) + 1;
+    n->map = (unsigned char *)arenaCalloc(q->ar, mapN);
+
+    if (in) {
+        if (!qEat(q, "(")) { qFail(q, "Expected ("); return NULL; }
+        do {
+            if (!qWord(q, v, sizeof v) || !qMark(q, n, v, true)) return NULL;
+        } while (qEat(q, ","));
+        if (!qEat(q, ")")) { qFail(q, "Expected )"); return NULL; }
+    } else if (!qWord(q, v, sizeof v) || !qMark(q, n, v, glob)) return NULL;
+    return neg ? qWrap(q, qNot, n) : n;
+}
+
+static QNODE *qFactor(QPARSE *q)
+{
+    if (qEat(q, "!")) { QNODE *k = qFactor(q); return k ? qWrap(q, qNot, k) : NULL; }
+    if (qEat(q, "(")) {
+        QNODE *k = qExpr(q);
+        if (k && !qEat(q, ")")) { qFail(q, "Expected )"); return NULL; }
+        return k;
+    }
+    return qPred(q);
+}
+
+/* one && or || level: kids joined by ‘tok’ */
+static QNODE *qList(QPARSE *q, int op, const char *tok, QNODE *(*next)(QPARSE *))
+{
+    QNODE *kid[cQMaxKids]; int n = 0;
+    do {
+        if (n == cQMaxKids) { qFail(q, "Too many terms"); return NULL; }
+        if (!(kid[n++] = next(q))) return NULL;
+    } while (qEat(q, tok));
+    if (n == 1) return kid[0];
+    QNODE *r = qNew(q, op, 0);
+    r->kid = (QNODE **)arenaAlloc(q->ar, n * sizeof *r->kid);
+    cyvaMemcpy(r->kid, kid, n * sizeof *kid);
+    r->nKid = n;
+    return r;
+}
+
+static QNODE *qTerm(QPARSE *q) { return qList(q, qAnd, "&&", qFactor); }
+static QNODE *qExpr(QPARSE *q) { return qList(q, qOr,  "||", qTerm); }
+
+/* the rows of a[0..na) not in b[0..nb), both ascending, into a */
+static int qMinus(int *a, int na, const int *b, int nb)
+{
+    int k = 0;
+    for (int i = 0, j = 0; i < na; ++i) {
+        while (j < nb && b[j] < a[i]) ++j;
+        if (j == nb || b[j] != a[i]) a[k++] = a[i];
+    }
+    return k;
+}
+
+/* keeps the rows of sel[0..n) that pass q, in order; new count */
+static int qEval(const QNODE *q, int *sel, int n)
+{
+    const EVCOLS *c = &lg.ev;
+    int k = 0;
+    switch (q->op) {
+    case qRange: {                               /* lo <= v <= hi as one compare */
+        if (q->lo > q->hi) return 0;
+        unsigned long long lo = (unsigned long long)q->lo,
+                           span = (unsigned long long)q->hi - lo;
+        if (q->field == qfId)
+            for (int i = 0; i < n; ++i) {
+                int r = sel[i]; sel[k] = r;
+                k += (unsigned long long)c->id[r] - lo <= span;
+            }
+        else
+            for (int i = 0; i < n; ++i) {
+                int r = sel[i]; sel[k] = r;
+                k += (unsigned long long)c->t[r] - lo <= span;
+            }
+        return k;
+    }
+    case qMap: {
+        const unsigned char *m = q->map;
+        const int *col = q->field == qfAcct ? c->acct : q->field == qfHost ? c->host : c->ws;
+        if (q->field == qfId)
+            for (int i = 0; i < n; ++i) { int r = sel[i]; sel[k] = r; k += m[c->id[r]]; }
+        else if (q->field == qfKind)
+            for (int i = 0; i < n; ++i) { int r = sel[i]; sel[k] = r; k += m[c->kind[r]]; }
+        else if (q->field == qfSrc)
+            for (int i = 0; i < n; ++i) {
+                int r = sel[i]; sel[k] = r;
+                k += m[c->ws[r] + 1] | m[c->ip[r] + 1];
+            }
+        else
+            for (int i = 0; i < n; ++i) { int r = sel[i]; sel[k] = r; k += m[col[r] + 1]; }
+        return k;
+    }
+    case qAnd:
+        for (int i = 0; i < q->nKid && n; ++i) n = qEval(q->kid[i], sel, n);
+        return n;
+    case qNot: {
+        int *hit = (int *)xmalloc((n + 1) * sizeof *hit);
+        cyvaMemcpy(hit, sel, n * sizeof *sel);
+        int m = qEval(q->kid[0], hit, n);
+        n = qMinus(sel, n, hit, m);
+        free(hit);
+        return n;
+    }
+    default: {                                   /* qOr */
+        int *rest = (int *)xmalloc((n + 1) * sizeof *rest);
+        int *hit  = (int *)xmalloc((n + 1) * sizeof *hit);
+        int  nr   = n;
+        cyvaMemcpy(rest, sel, n * sizeof *sel);
+        for (int i = 0; i < q->nKid && nr; ++i) {
+            cyvaMemcpy(hit, rest, nr * sizeof *rest);
+            int m = qEval(q->kid[i], hit, nr);
+            nr = qMinus(rest, nr, hit, m);
+        }
+        n = qMinus(sel, n, rest, nr);            /* all but the misses */
+        free(rest); free(hit);
+        return n;
+    }
+    }
+}
+
+static int cmpPassUp(const void *a, const void *b)
+{
+    double x = (*(QNODE *const *)a)->pass, y = (*(QNODE *const *)b)->pass;
+    return (x > y) - (x < y);
+}
+static int cmpPassDown(const void *a, const void *b) { return cmpPassUp(b, a); }
+
+/* measures every node on the sample and orders && / || terms */
+static void qRank(QNODE *q, const int *sample, int ns, int *scratch)
+{
+    for (int i = 0; i < q->nKid; ++i) qRank(q->kid[i], sample, ns, scratch);
+    if (q->op == qAnd) qsort(q->kid, q->nKid, sizeof *q->kid, cmpPassUp);
+    if (q->op == qOr)  qsort(q->kid, q->nKid, sizeof *q->kid, cmpPassDown);
+    cyvaMemcpy(scratch, sample, ns * sizeof *sample);
+    q->pass = ns ? (double)qEval(q, scratch, ns) / ns : 0;
+}
+
+/* parses and ranks ‘text’ against ‘lg’; NULL (and err) on a
+   syntax error.  Nodes live in ‘ar’. */
+static QNODE *qCompile(const char *text, ARENA *ar, char *err, size_t errCap)
+{
+    QPARSE q = { text, text, ar, "" };
+    QNODE *root = qExpr(&q);
+    qSkip(&q);
+    if (root && *q.p) { qFail(&q, "Unexpected text"); root = NULL; }
+    if (!root) { cyvaStrcpy_cap(err, errCap, q.err); return NULL; }
+
+    int ns = lg.ev.n < cQSample ? lg.ev.n : cQSample;
+    int *sample  = (int *)xmalloc((ns + 1) * sizeof *sample);
+    int *scratch = (int *)xmalloc((ns + 1) * sizeof *scratch);
+    for (int i = 0; i < ns; ++i) sample[i] = (int)((long long)i * lg.ev.n / ns);
+    qRank(root, sample, ns, scratch);
+    free(sample); free(scratch);
+    return root;
+}
+
+static void runQuery(const char *text)
+{
+    if (lg.aggOnly) { puts("  Queries need the events (not an aggregate-only load).\n"); return; }
+
+    ARENA ar = {0}; char err[96];
+    double t0 = nowSec();
+    QNODE *q = qCompile(text, &ar, err, sizeof err);
+    if (!q) { printf("  %s\n\n", err); arenaFree(&ar); return; }
+
+    double t1 = nowSec();
+    int *sel = (int *)xmalloc((lg.ev.n + 1) * sizeof *sel);
+    for (int i = 0; i < lg.ev.n; ++i) sel[i] = i;
+    int n = qEval(q, sel, lg.ev.n);
+    double t2 = nowSec();
+
+    char num[24], num2[24], when[32];
+    printf("\n%s of %s events match (compiled in %.2f ms, ran in %.2f ms).\n",
+           fmtCount(n, num), fmtCount(lg.ev.n, num2), (t1 - t0) * 1e3, (t2 - t1) * 1e3);
+    for (int k = 0; k < n && k < 20; ++k) {
+        int i = sel[k];
+        int s = lg.ev.ws[i] >= 0 ? lg.ev.ws[i] : lg.ev.ip[i];
+        printf("  %s  %5u  %-20s %-18s %s\n", fmtTime(lg.ev.t[i], when, sizeof when),
+               lg.ev.id[i], lg.ev.acct[i] >= 0 ? lg.acct[lg.ev.acct[i]].name : "-",
+               s >= 0 ? lg.src.v[s] : "-", lg.ev.host[i] >= 0 ? lg.host.v[lg.ev.host[i]] : "-");
+    }
+    if (n > 20) printf("  … %s more\n", fmtCount(n - 20, num));
+    puts("");
+    free(sel);
+    arenaFree(&ar);
+}
+
+/* -- 18.  Mini interactive driver ------------------------- */
+static bool promptLoad(void)
+{
+    char path[260];
+    printf("\nCSV file, directory, wildcard, .cyvalog snapshot or |command: "); fgets(path, sizeof path, stdin);
+    path[CSPRINT(path, "\r\n")] = '\0';
+    if (!*path) { puts("Cancelled.\n"); return false; }
+
+    char mode[16];
+    printf("Aggregate-only streaming, bounded memory [y/N]: ");
+    fgets(mode, sizeof mode, stdin);
+
+    closeDataset();                             /* one dataset at a time */
+    return loadPath(path, *mode == 'y' || *mode == 'Y');
+}
+
+static void listBruteForce(void)
+{
+    char when[32], num[24];
+    printf("\nBrute-force alerts (>= %d failures in %d s):\n", bfThreshold, bfWindow);
+    for (int i = 0; i < lg.bfCnt; ++i) {
+        const BFALERT *al = &lg.bfAl[i];
+        printf("  %-24s %s  (%s in window)\n", lg.acct[al->acct].name,
+               fmtTime(al->t, when, sizeof when), fmtCount(al->cnt, num));
+    }
+    if (!lg.bfCnt) puts("  (none)");
+    puts("");
+}
+
+static void listSpray(void)
+{
+    char when[32], num[24];
+    printf("\nPassword-spray sources (>= %d accounts in a %d s window, ~6.5%%):\n",
+           spThreshold, spWindow);
+    for (int i = 0; i < lg.spCnt; ++i) {
+        const SPALERT *al = &lg.spAl[i];
+        printf("  %-24s %s  (~%s accounts)\n", lg.src.v[al->src],
+               fmtTime(al->t, when, sizeof when), fmtCount(al->est, num));
+    }
+    if (!lg.spCnt) puts("  (none)");
+    puts("");
+}
+
+/* -----------------------------------------------------------
+   Session report  –  accounts by total logged-on time, then
+   the sessions still open, oldest first (at most cSessShow).
+   ----------------------------------------------------------- */
+#define cSessShow 50
+
+static int cmpSessSec(const void *a, const void *b)
+{
+    const ACCT *x = &lg.acct[*(const int *)a], *y = &lg.acct[*(const int *)b];
+    return (x->sessSec < y->sessSec) - (x->sessSec > y->sessSec);
+}
+static int cmpOpenT(const void *a, const void *b)
+{
+    const SSOPEN *x = a, *y = b;
+    return (x->t > y->t) - (x->t < y->t);
+}
+
+static void listSessions(void)
+{
+    char num[24], tot[32], mx[32], when[32];
+    int *ord = (int*)xmalloc((lg.aCnt + 1) * sizeof *ord), n = 0;
+    for (int i = 0; i < lg.aCnt; ++i)
+        if (lg.acct[i].sess || lg.acct[i].sessOpen || lg.acct[i].sessLost) ord[n++] = i;
+    qsort(ord, n, sizeof *ord, cmpSessSec);
+
+    printf("\nLogon sessions (timeout %d s):\n", ssTimeout);
+    if (n) printf("  %-24s %8s %6s %9s  %-13s %s\n",
+                  "account", "closed", "open", "timed out", "total", "longest");
+    for (int r = 0; r < n; ++r) {
+        const ACCT *a = &lg.acct[ord[r]];
+        printf("  %-24s %8s %6d %9d  %-13s %s\n", a->name, fmtCount(a->sess, num),
+               a->sessOpen, a->sessLost, fmtDur(a->sessSec, tot, sizeof tot),
+               fmtDur(a->sessMax, mx, sizeof mx));
+    }
+    if (!n) puts("  (none)");
+    free(ord);
+
+    SSOPEN *open = (SSOPEN*)xmalloc((lg.ssCnt + 1) * sizeof *open);
+    n = 0;
+    for (int i = 0; i < lg.ssCap; ++i) if (lg.ss[i].lid) open[n++] = lg.ss[i];
+    qsort(open, n, sizeof *open, cmpOpenT);
+    printf("\nStill open (%s):\n", fmtCount(n, num));
+    for (int i = 0; i < n && i < cSessShow; ++i)
+        printf("  %s  %-24s %-18s 0x%llX\n", fmtTime(open[i].t, when, sizeof when),
+               lg.acct[open[i].acct].name,
+               open[i].host >= 0 ? lg.host.v[open[i].host] : "-", open[i].lid);
+    if (n > cSessShow) printf("  … %s more\n", fmtCount(n - cSessShow, num));
+    if (!n) puts("  (none)");
+    puts("");
+    free(open);
+}
+
+/* -----------------------------------------------------------
+   Network report  –  failed logons under one prefix (or all
+   sources), grouped into /N networks, largest first.  The
+   prefix costs one trie descent and the grouping a walk over
+   the nodes above the /N cut, whatever the address count.
+   ----------------------------------------------------------- */
+#define cNetShow 20
+
+static const IPNODE *sortNet;                   /* qsort context */
+
+static int cmpNetFails(const void *a, const void *b)
+{
+    const IPNODE *x = &sortNet[*(const int *)a], *y = &sortNet[*(const int *)b];
+    return (x->fails < y->fails) - (x->fails > y->fails);
+}
+
+static void showNetworks(int fam, const IPKEY *k, int len, int cut)
+{
+    char net[64], num[24], addrs[24];
+    const IPTRIE *t = &lg.net;
+    int at = ipFind(t, fam, k, len);
+    if (cut < len) cut = len;
+    if (cut > ipMaxBits(fam)) cut = ipMaxBits(fam);
+
+    ipFmt(fam, *k, len, net, sizeof net);
+    if (!at) { printf("\nNo failed logons from %s.\n", net); return; }
+    printf("\nFailed logons from %s: %s from %s addresses\n", net,
+           fmtCount(t->n[at].fails, num), fmtCount(t->n[at].addrs, addrs));
+
+    int *grp = (int*)xmalloc((t->n[at].addrs + 1) * sizeof *grp), n = 0;
+    ipGroups(t, at, cut, grp, &n);
+    sortNet = t->n;
+    qsort(grp, n, sizeof *grp, cmpNetFails);
+    printf("  %s /%d network%s:\n", fmtCount(n, num), cut, n == 1 ? "" : "s");
+    for (int r = 0; r < n && r < cNetShow; ++r) {
+        const IPNODE *g = &t->n[grp[r]];
+        printf("  %3d  %-40s %10s  (%s addresses)\n", r + 1, ipFmt(fam, g->key, cut, net, sizeof net),
+               fmtCount(g->fails, num), fmtCount(g->addrs, addrs));
+    }
+    if (n > cNetShow) printf("  … %s more\n", fmtCount(n - cNetShow, num));
+    free(grp);
+}
+
+static void listNetworks(void)
+{
+    char buf[96], pre[96];
+    printf("Prefix (10.20.0.0/16, 2001:db8::/32; empty = all sources): ");
+    if (!fgets(pre, sizeof pre, stdin)) return;
+    pre[CSPRINT(pre, "\r\n")] = '\0';
+
+    IPKEY k = {0, 0}; int fam = -1, len = 0;
+    if (*pre) {
+        size_t n = CSPRINT(pre, "/");
+        fam = ipParse(pre, n, &k);
+        if (fam < 0) { puts("  Not an address."); return; }
+        char *end; len = pre[n] ? (int)cyvaStrtol(pre + n + 1, &end, 10) : ipMaxBits(fam);
+        if (pre[n] && (*end || end == pre + n + 1)) len = -1;
+        if (len < 0 || len > ipMaxBits(fam)) { puts("  Bad prefix length."); return; }
+    }
+    printf("Group by /N [%s]: ", fam < 0 ? "24 for IPv4, 64 for IPv6" : fam ? "64" : "24");
+    if (!fgets(buf, sizeof buf, stdin)) return;
+    int cut = atoi(buf + (*buf == '/'));
+
+    if (fam >= 0) { showNetworks(fam, &k, len, cut > 0 ? cut : fam ? 64 : 24); puts(""); return; }
+    showNetworks(0, &k, 0, cut > 0 ? cut : 24);
+    if (lg.net.root[1]) showNetworks(1, &k, 0, cut > 0 ? cut : 64);
+    puts("");
+}
+
+/* -----------------------------------------------------------
+   Heavy-hitter report  –  the ‘n’ largest counters of a TOPK,
+   largest first.  A count is exact when err is 0, otherwise
+   the true value is at least cnt - err.
+   ----------------------------------------------------------- */
+static const TOPC *sortTop;                     /* qsort context */
+
+static int cmpTopCnt(const void *a, const void *b)
+{
+    const TOPC *x = &sortTop[*(const int *)a], *y = &sortTop[*(const int *)b];
+    return (x->cnt < y->cnt) - (x->cnt > y->cnt);
+}
+
+static void listTop(const TOPK *k, const char *what, int n)
+{
+    char num[24], lo[24];
+    int *ord = (int*)xmalloc((k->n + 1) * sizeof *ord);
+    for (int i = 0; i < k->n; ++i) ord[i] = i;
+    sortTop = k->c;
+    qsort(ord, k->n, sizeof *ord, cmpTopCnt);
+
+    if (n > k->n) n = k->n;
+    printf("\nTop %d %s (%s failures", n, what, fmtCount((int)k->total, num));
+    if (k->cap && k->n == k->cap)
+        printf(", %d counters: counts may be up to %s high", k->cap,
+               fmtCount((int)(k->total / k->cap), lo));
+    puts("):");
+    for (int r = 0; r < n; ++r) {
+        const TOPC *c = &k->c[ord[r]];
+        printf("  %3d  %-32s %10s", r + 1, c->key, fmtCount(c->cnt, num));
+        if (c->err) printf("  (>= %s)", fmtCount(c->cnt - c->err, lo));
+        puts("");
+    }
+    if (!n) puts("  (none)");
+    free(ord);
+}
+
+static void listTopAll(void)
+{
+    char buf[32]; int n = 50;
+    printf("How many per list [50]: ");
+    if (fgets(buf, sizeof buf, stdin) && atoi(buf) > 0) n = atoi(buf);
+    listTop(&lg.top[tkAcct],   "failing accounts",     n);
+    listTop(&lg.top[tkWs],     "failing workstations", n);
+    listTop(&lg.top[tkReason], "failure reasons",      n);
+    puts("");
+}
+
+static void promptSave(void)
+{
+    char path[260];
+    printf("Snapshot path (.cyvalog): "); fgets(path, sizeof path, stdin);
+    path[CSPRINT(path, "\r\n")] = '\0';
+    if (!*path) { puts("  Cancelled."); return; }
+    if (saveSnapshot(&lg, path, NULL)) printf("  Saved %s\n", path);
+}
+
+/* lock-outs and alerts that arrived since the given counts */
+static void followShow(int ev0, int bf0, int sp0)
+{
+    char when[32], num[24];
+    for (int i = ev0; i < lg.ev.n; ++i)
+        if (lg.ev.kind[i] & evLock)
+            printf("  %s  locked out      %s\n", fmtTime(lg.ev.t[i], when, sizeof when),
+                   lg.acct[lg.ev.acct[i]].name);
+    for (int i = bf0; i < lg.bfCnt; ++i)
+        printf("  %s  brute force     %s (%s in window)\n",
+               fmtTime(lg.bfAl[i].t, when, sizeof when),
+               lg.acct[lg.bfAl[i].acct].name, fmtCount(lg.bfAl[i].cnt, num));
+    for (int i = sp0; i < lg.spCnt; ++i)
+        printf("  %s  password spray  %s\n",
+               fmtTime(lg.spAl[i].t, when, sizeof when), lg.src.v[lg.spAl[i].src]);
+}
+
+static void followMenu(void)
+{
+    char path[260]; FOLLOW f;
+    printf("CSV to follow: "); fgets(path, sizeof path, stdin);
+    path[CSPRINT(path, "\r\n")] = '\0';
+    if (!*path || !followStart(&f, path)) return;
+    printf("Following %s (%d events).  Press Enter to stop.\n", f.path, lg.ev.n);
+
+    for (;;) {
+        if (waitInput(cFollowPollMs)) { char line[16]; fgets(line, sizeof line, stdin); break; }
+        int ev0 = lg.ev.n, bf0 = lg.bfCnt, sp0 = lg.spCnt;
+        int n = followPoll(&f);
+        if (n < 0) {
+            puts("File was replaced; reading it again.");
+            if (!followStart(&f, f.path)) return;
+            continue;
+        }
+        if (n) followShow(ev0, bf0, sp0);
+        if (f.dirty && time(NULL) - f.saved >= cCkptSecs) followSave(&f);
+    }
+    followSave(&f);
+    lg.live = false;
+    printf("Stopped at byte %lld; checkpoint %s\n", f.at.offset, f.ckpt);
+}
+
+static void setTopCap(void)
+{
+    char buf[32];
+    printf("Counters per top-K list, %d bytes each [%d]: ", (int)sizeof(TOPC), topCap);
+    if (!fgets(buf, sizeof buf, stdin) || atoi(buf) < 1) { puts("  Unchanged."); return; }
+    topCap = atoi(buf);
+    puts("  Applies to the next load.");
+}
+
+/* "N M" into *n, *m; false (values kept) on empty/bad input */
+static bool promptPair(const char *what, int *n, int *m)
+{
+    char buf[64]; int a, b;
+    printf("%s [%d %d]: ", what, *n, *m);
+    if (!fgets(buf, sizeof buf, stdin) || sscanf(buf, "%d %d", &a, &b) != 2 ||
+        a < 1 || b < 1) { puts("  Unchanged."); return false; }
+    *n = a; *m = b;
+    return true;
+}
+
+/* one positive number into *v; false (value kept) otherwise */
+static bool promptOne(const char *what, int *v)
+{
+    char buf[32]; int a;
+    printf("%s [%d]: ", what, *v);
+    if (!fgets(buf, sizeof buf, stdin) || sscanf(buf, "%d", &a) != 1 || a < 1)
+        { puts("  Unchanged."); return false; }
+    *v = a;
+    return true;
+}
+
+static void setThresholds(void)
+{
+    bool bf = promptPair("Brute force as \"N M\" (N failures in M seconds)",
+                         &bfThreshold, &bfWindow);
+    bool sp = promptPair("Spray as \"N M\" (N accounts from one source in M seconds)",
+                         &spThreshold, &spWindow);
+    bool ss = promptOne("Logon sessions time out after (seconds)", &ssTimeout);
+    if (!bf && !sp && !ss) return;
+    if (lg.aggOnly) puts("  Applies to the next streamed load.");
+    else            runDetectors(&lg);
+}
+
+/* a time as parseLocal() reads it; an empty answer leaves the
+   bound open. */
+static bool promptTime(const char *what, long long *out, long long open)
+{
+    char buf[64];
+    printf("%s (YYYY-MM-DD HH:MM[:SS], empty = open): ", what);
+    if (!fgets(buf, sizeof buf, stdin)) return false;
+    buf[CSPRINT(buf, "\r\n")] = '\0';
+    if (!*buf) { *out = open; return true; }
+
+    if (!parseLocal(buf, out)) { puts("  Bad time."); return false; }
+    return true;
+}
+
+static bool promptWindow(long long *t0, long long *t1)
+{
+    return promptTime("From", t0, cNoTime) &&
+           promptTime("To  ", t1,  0x7FFFFFFFFFFFFFFFLL);
+}
+
+static void LogAnalysisMenu(void)
+{
+    if (!promptLoad()) return;
+
+    for (;;) {
+        puts("\n== NXLog Log-Analysis ==");
+        puts(" 1  List all accounts");
+        puts(" 2  List locked-out accounts");
+        puts(" 3  Query account");
+        puts(" 4  Open another CSV");
+        puts(" 5  Query account in time range");
+        puts(" 6  List locked-out accounts in time range");
+        puts(" 7  Brute-force alerts");
+        puts(" 8  Set detection thresholds");
+        puts(" 9  Password-spray sources");
+        puts("10  Top-K failing accounts / workstations / reasons");
+        puts("11  Set top-K memory");
+        puts("12  Save snapshot");
+        puts("13  Follow a growing CSV");
+        puts("14  Query events");
+        puts("15  Logon sessions");
+        puts("16  Failed logons by network");
+        puts(" 0  Back");
+        printf("> ");
+
+        char line[16];
+        if (!fgets(line, sizeof line, stdin)) break;
+        char *end; long v = strtol(line, &end, 10);
+        int   ch  = end == line ? -1 : (int)v;   /* -1: not a number */
+        if (ch == 0) break;
+        if (ch == 1) { listAccountsAll();    continue; }
+        if (ch == 2) { listAccountsLocked(); continue; }
+        if (ch == 3) {
+            char buf[128];
+            printf("Account name: "); fgets(buf, sizeof buf, stdin);
+            buf[CSPRINT(buf, "\r\n")] = '\0';
+            if (*buf) showAccount(buf);
+            continue;
+        }
+        if (ch == 4) { if (!promptLoad()) break; continue; }
+        if (ch == 5) {
+            char buf[128]; long long t0, t1;
+            printf("Account name: "); fgets(buf, sizeof buf, stdin);
+            buf[CSPRINT(buf, "\r\n")] = '\0';
+            if (*buf && promptWindow(&t0, &t1)) showAccountRange(buf, t0, t1);
+            continue;
+        }
+        if (ch == 7)  { listBruteForce(); continue; }
+        if (ch == 8)  { setThresholds();  continue; }
+        if (ch == 9)  { listSpray();      continue; }
+        if (ch == 10) { listTopAll();     continue; }
+        if (ch == 11) { setTopCap();      continue; }
+        if (ch == 12) { promptSave();     continue; }
+        if (ch == 13) { followMenu();     continue; }
+        if (ch == 15) { listSessions();   continue; }
+        if (ch == 16) { listNetworks();   continue; }
+        if (ch == 14) {
+            char buf[512];
+            printf("Query (e.g. id in (4625,4771) && account ~ \"svc_*\"): ");
+            if (!fgets(buf, sizeof buf, stdin)) break;
+            buf[CSPRINT(buf, "\r\n")] = '\0';
+            if (*buf) runQuery(buf);
+            continue;
+        }
+        if (ch == 6) {
+            long long t0, t1;
+            if (promptWindow(&t0, &t1)) listAccountsLockedRange(t0, t1);
             continue;
         }
         puts("Invalid choice.\n");
     }
+    closeDataset();
 }
 
 #endif /* LOG_ANALYSIS_H */